@@ -0,0 +1,101 @@
+# Adversarial inputs for the link parsers.
+#
+#   ruby -Ilib bench/adversarial.rb [--json PATH]
+#
+# Every pattern is linked at several sizes; the time per byte must stay
+# flat as the input grows. If the largest input costs more than
+# MAX_GROWTH times as much per byte as the smallest one, the pattern is
+# reported as superlinear and the script exits with an error.
+require 'json'
+require 'optparse'
+require 'stringio'
+require 'rinku'
+
+module RinkuBench
+  module Adversarial
+    MAX_GROWTH = 3.0
+    SIZES = [16, 32, 64, 128].map { |kb| kb * 1024 }
+
+    PATTERNS = {
+      "emails_chained"     => ->(n) { "a@" * (n / 2) },
+      "emails_dotted"      => ->(n) { "a." * (n / 2) + "@" },
+      "emails_many_at"     => ->(n) { "a.b-c@" * (n / 6) },
+      "www_chained"        => ->(n) { "www." * (n / 4) + "a_b.c_d" },
+      "www_before_tags"    => ->(n) { "www.x<," * (n / 7) },
+      "www_no_spaces"      => ->(n) { "www.x/" * (n / 6) },
+      "schemes_empty"      => ->(n) { "x://" * (n / 4) },
+      "schemes_unsafe"     => ->(n) { "a://a.b/" * (n / 8) },
+      "schemes_short"      => ->(n) { "http://a" * (n / 8) },
+      "dotted_domain"      => ->(n) { "http://" + "a." * (n / 2) },
+      "trailing_entities"  => ->(n) { "http://x.com/" + "&amp;" * (n / 5) },
+      "trailing_punct"     => ->(n) { "http://x.com/" + ".," * (n / 2) },
+      "nested_parens"      => ->(n) { "(" * (n / 2) + "http://x.com/" + ")" * (n / 2) },
+      "lone_lt"            => ->(n) { "<" * n },
+      "open_tags"          => ->(n) { "<a " * (n / 3) },
+      "open_comments"      => ->(n) { "<!--" * (n / 4) },
+      "open_skipped"       => ->(n) { "<code>" * (n / 6) },
+      "close_prefixes"     => ->(n) { "<code>" + "</cod" * (n / 5) },
+      "stream_no_spaces"   => ->(n) { "www.x/" * (n / 6) },
+    }.freeze
+
+    # Patterns fed to a Rinku::Stream in small chunks instead
+    STREAMED = %w[stream_no_spaces].freeze
+    CHUNK_SIZE = 64
+
+    module_function
+
+    def stream(text)
+      stream = Rinku::Stream.new(StringIO.new)
+      0.step(text.bytesize - 1, CHUNK_SIZE) do |pos|
+        stream << text.byteslice(pos, CHUNK_SIZE)
+      end
+      stream.finish
+    end
+
+    # Best of a few runs, in nanoseconds per byte
+    def ns_per_byte(text, runs, streamed)
+      best = Float::INFINITY
+      runs.times do
+        start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        streamed ? stream(text) : Rinku.auto_link(text)
+        best = [best, Process.clock_gettime(Process::CLOCK_MONOTONIC) - start].min
+      end
+      best * 1e9 / text.bytesize
+    end
+
+    def run(argv)
+      options = { runs: 5 }
+      OptionParser.new do |opts|
+        opts.on("--json PATH", "also write the results as JSON") { |path| options[:json] = path }
+        opts.on("--runs N", Integer, "runs per size, the best one counts (default 5)") { |n| options[:runs] = n }
+      end.parse!(argv)
+
+      # Keep every size on the same code path
+      Rinku.nogvl_threshold = nil
+      results = []
+
+      PATTERNS.each do |name, build|
+        streamed = STREAMED.include?(name)
+        costs = SIZES.map { |size| ns_per_byte(build.(size), options[:runs], streamed) }
+        growth = costs.last / costs.first
+
+        results << {
+          "pattern" => name,
+          "sizes" => SIZES,
+          "ns_per_byte" => costs.map { |c| c.round(3) },
+          "growth" => growth.round(2),
+          "linear" => growth <= MAX_GROWTH,
+        }
+
+        printf("%-20s %s  growth %6.2fx%s\n", name,
+          costs.map { |c| format("%9.2f", c) }.join(" "), growth,
+          growth <= MAX_GROWTH ? "" : "  SUPERLINEAR")
+      end
+
+      File.write(options[:json], JSON.pretty_generate(results) + "\n") if options[:json]
+      results.all? { |r| r["linear"] }
+    end
+  end
+end
+
+exit(RinkuBench::Adversarial.run(ARGV) ? 0 : 1) if $0 == __FILE__
@@ -0,0 +1,131 @@
+# Throughput and allocation benchmarks for Rinku.
+#
+#   ruby -Ilib bench/bench.rb [--json PATH] [--corpus NAME,...] [--iterations N]
+#
+# Every corpus is linked with Rinku.auto_link, with a Rinku::Linker, and
+# with the regex-based linker from rails_autolink as a baseline. Results
+# are printed as a table, and written as JSON with `--json`.
+require 'json'
+require 'optparse'
+require 'time'
+require 'rinku'
+require_relative 'corpus'
+require_relative 'rails_autolink'
+
+module RinkuBench
+  module_function
+
+  BASELINE = "rails_regex"
+
+  def implementations(baseline)
+    linker = Rinku::Linker.new
+    impls = {
+      "rinku" => ->(text) { Rinku.auto_link(text) },
+      "rinku_linker" => ->(text) { linker.auto_link(text) },
+    }
+
+    impls[BASELINE] = ->(text) { RailsAutolink.auto_link(text) } if baseline
+    impls
+  end
+
+  def clock
+    Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  end
+
+  def percentile(sorted, pct)
+    sorted[((sorted.size - 1) * pct / 100.0).round]
+  end
+
+  def allocations(impl, docs)
+    GC.start
+    GC.disable
+    objects = GC.stat(:total_allocated_objects)
+    malloc = GC.stat(:malloc_increase_bytes)
+
+    docs.each { |doc| impl.call(doc) }
+
+    [GC.stat(:total_allocated_objects) - objects, GC.stat(:malloc_increase_bytes) - malloc]
+  ensure
+    GC.enable
+  end
+
+  def measure(corpus, name, impl, docs, iterations)
+    bytes = docs.sum(&:bytesize)
+    links = docs.sum { |doc| Rinku.link_offsets(doc).bytesize / 12 }
+    latencies = []
+
+    docs.each { |doc| impl.call(doc) } # warm up
+
+    iterations.times do
+      docs.each do |doc|
+        start = clock
+        impl.call(doc)
+        latencies << clock - start
+      end
+    end
+
+    seconds = latencies.sum
+    latencies.sort!
+    objects, malloc = allocations(impl, docs)
+
+    {
+      "corpus" => corpus,
+      "implementation" => name,
+      "documents" => docs.size,
+      "bytes" => bytes,
+      "links" => links,
+      "iterations" => iterations,
+      "seconds" => seconds.round(6),
+      "mb_per_s" => (bytes * iterations / seconds / 1e6).round(3),
+      "links_per_s" => (links * iterations / seconds).round(1),
+      "p50_us" => (percentile(latencies, 50) * 1e6).round(2),
+      "p99_us" => (percentile(latencies, 99) * 1e6).round(2),
+      "objects_per_doc" => (objects.to_f / docs.size).round(2),
+      "malloc_bytes_per_doc" => (malloc.to_f / docs.size).round(1),
+    }
+  end
+
+  def report(results)
+    columns = %w(corpus implementation mb_per_s links_per_s p50_us p99_us objects_per_doc malloc_bytes_per_doc)
+    widths = columns.map { |c| [c.size, *results.map { |r| r[c].to_s.size }].max }
+
+    puts columns.zip(widths).map { |c, w| c.ljust(w) }.join("  ")
+    results.each do |r|
+      puts columns.zip(widths).map { |c, w| r[c].is_a?(Numeric) ? r[c].to_s.rjust(w) : r[c].to_s.ljust(w) }.join("  ")
+    end
+  end
+
+  def run(argv)
+    options = { corpora: Corpus.names, iterations: Integer(ENV.fetch("ITERATIONS", 3)), baseline: true }
+
+    OptionParser.new do |opts|
+      opts.on("--json PATH", "also write the results as JSON") { |path| options[:json] = path }
+      opts.on("--corpus NAMES", Array, "only run these corpora (#{Corpus.names.join(',')})") { |n| options[:corpora] = n }
+      opts.on("--iterations N", Integer, "passes over each corpus (default 3)") { |n| options[:iterations] = n }
+      opts.on("--[no-]baseline", "compare against #{BASELINE} (one pass only)") { |b| options[:baseline] = b }
+    end.parse!(argv)
+
+    results = []
+    options[:corpora].each do |corpus|
+      docs = Corpus.generate(corpus)
+      implementations(options[:baseline]).each do |name, impl|
+        # the regex baseline is two orders of magnitude slower
+        iterations = name == BASELINE ? 1 : options[:iterations]
+        results << measure(corpus, name, impl, docs, iterations)
+      end
+    end
+
+    report(results)
+
+    if options[:json]
+      File.write(options[:json], JSON.pretty_generate(
+        "rinku_version" => Rinku::VERSION,
+        "ruby" => RUBY_DESCRIPTION,
+        "time" => Time.now.utc.iso8601,
+        "results" => results,
+      ) + "\n")
+    end
+  end
+end
+
+RinkuBench.run(ARGV) if $0 == __FILE__
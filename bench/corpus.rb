@@ -0,0 +1,117 @@
+# Generates the benchmark corpora. Everything is derived from a fixed
+# seed, so every run (and every release) links exactly the same bytes.
+module RinkuBench
+  module Corpus
+    WORDS = %w(
+      the of and to in is that for it as was with be by on not he this are or
+      his from at which but have an they you were her she there been one all
+      we their has would when if so no will can more about out up them some
+      could into than other time its only new like these two may first then
+      do any now such people over my most also after made well where our
+      release build merge review patch thread commit branch issue deploy
+    ).freeze
+
+    DOMAINS = %w(
+      github.com example.com rubygems.org ruby-lang.org news.ycombinator.com
+      en.wikipedia.org docs.google.com stackoverflow.com
+    ).freeze
+
+    CJK = "日本語のテキストです情報処理学会東京大阪京都中文文本链接在这里한국어텍스트입니다".chars.freeze
+
+    module_function
+
+    def url(rng)
+      path = Array.new(rng.rand(0..3)) { WORDS.sample(random: rng) }.join("/")
+      query = rng.rand(4).zero? ? "?id=#{rng.rand(100_000)}&ref=#{WORDS.sample(random: rng)}" : ""
+      scheme = rng.rand(5).zero? ? "www." : %w(http:// https://).sample(random: rng)
+      "#{scheme}#{DOMAINS.sample(random: rng)}/#{path}#{query}"
+    end
+
+    def email(rng)
+      "#{WORDS.sample(random: rng)}.#{WORDS.sample(random: rng)}@#{DOMAINS.sample(random: rng)}"
+    end
+
+    def sentence(rng, link_every)
+      words = Array.new(rng.rand(8..20)) do
+        rng.rand(link_every).zero? ? url(rng) : WORDS.sample(random: rng)
+      end
+      words.join(" ").capitalize + %w(. . . ! ?).sample(random: rng)
+    end
+
+    def prose(rng, size)
+      doc = +""
+      doc << sentence(rng, 40) << (rng.rand(6).zero? ? "\n\n" : " ") while doc.bytesize < size
+      doc
+    end
+
+    def html(rng, size)
+      doc = +""
+      while doc.bytesize < size
+        case rng.rand(6)
+        when 0
+          doc << "<pre><code class=\"language-ruby\">\n"
+          rng.rand(3..12).times { doc << "  fetch(\"#{url(rng)}\") if x > 1 && y < 2\n" }
+          doc << "</code></pre>\n"
+        when 1
+          doc << "<p>See <a href=\"#{url(rng)}\" title=\"a > b\">#{WORDS.sample(random: rng)}</a> and <code>#{url(rng)}</code>.</p>\n"
+        when 2
+          doc << "<!-- #{sentence(rng, 3)} -->\n"
+        else
+          doc << "<div class=\"comment\" data-id=\"#{rng.rand(10_000)}\"><p>#{sentence(rng, 12)}</p>" \
+                 "<span class='meta'>#{WORDS.sample(random: rng)}</span></div>\n"
+        end
+      end
+      doc
+    end
+
+    def emails(rng, size)
+      doc = +""
+      while doc.bytesize < size
+        doc << "From: #{email(rng)}\nTo: #{email(rng)}, #{email(rng)}\n"
+        doc << sentence(rng, 60) << " Contact <#{email(rng)}> or #{email(rng)}.\n\n"
+      end
+      doc
+    end
+
+    def cjk(rng, size)
+      doc = +""
+      while doc.bytesize < size
+        doc << Array.new(rng.rand(10..40)) { CJK.sample(random: rng) }.join
+        case rng.rand(4)
+        when 0 then doc << "（#{url(rng)}）"
+        when 1 then doc << "【#{url(rng)}】"
+        when 2 then doc << "「#{email(rng)}」"
+        end
+        doc << "。"
+      end
+      doc
+    end
+
+    def tiny(rng, _size)
+      case rng.rand(3)
+      when 0 then "+1"
+      when 1 then "#{WORDS.sample(random: rng).capitalize}! see #{url(rng)}"
+      else sentence(rng, 100)
+      end
+    end
+
+    # name => [documents, document size in bytes, generator]
+    SPECS = {
+      "prose" => [200, 8 * 1024, :prose],
+      "html"  => [60, 32 * 1024, :html],
+      "email" => [300, 4 * 1024, :emails],
+      "cjk"   => [200, 6 * 1024, :cjk],
+      "tiny"  => [20_000, 0, :tiny],
+    }.freeze
+
+    def names
+      SPECS.keys
+    end
+
+    def generate(name, seed: 0x5eed)
+      count, size, method = SPECS.fetch(name)
+      rng = Random.new(seed ^ name.sum)
+      Array.new(count) { send(method, rng, size).freeze }.freeze
+    end
+  end
+end
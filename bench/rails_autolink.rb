@@ -0,0 +1,66 @@
+require 'cgi'
+
+module RinkuBench
+  # The regex-based `auto_link` from the `rails_autolink` gem, without
+  # the ActionView dependency. Sanitization is left out, as with
+  # `sanitize: false`, so only the linking itself is compared.
+  module RailsAutolink
+    AUTO_LINK_RE = %r{
+        (?: ((?:ed2k|ftp|http|https|irc|mailto|news|gopher|nntp|telnet|webcal|xmpp|callto|feed|svn|urn|aim|rsync|tag|ssh|sftp|rtsp|afs|file):)// | www\. )
+        [^\s<\u00A0"]+
+      }ix
+    AUTO_LINK_CRE = [/<[^>]+$/, /^[^>]*>/, /<a\b.*?>/i, /<\/a>/i]
+    AUTO_EMAIL_LOCAL_RE = /[\w.!#\$%&'*\/=?^`{|}~+-]/
+    AUTO_EMAIL_RE = /[\w.!#\$%+-]\.?#{AUTO_EMAIL_LOCAL_RE}*@[\w-]+(?:\.[\w-]+)+/
+    BRACKETS = { ']' => '[', ')' => '(', '}' => '{' }
+    WORD_PATTERN = '\p{Word}'
+
+    module_function
+
+    def auto_link(text)
+      auto_link_email_addresses(auto_link_urls(text))
+    end
+
+    def auto_link_urls(text)
+      text.gsub(AUTO_LINK_RE) do
+        scheme, href = $1, $&
+        punctuation = []
+        trailing_gt = ""
+
+        if auto_linked?($`, $')
+          href
+        else
+          while href.sub!(/[^#{WORD_PATTERN}\/\-=;]$/, '')
+            punctuation.push $&
+            if (opening = BRACKETS[punctuation.last]) && href.scan(opening).size > href.scan(punctuation.last).size
+              href << punctuation.pop
+              break
+            end
+          end
+
+          trailing_gt = $& if href.sub!(/&gt;$/, '')
+
+          link_text = href
+          href = 'http://' + href unless scheme
+          %(<a href="#{CGI.escapeHTML(href)}">#{link_text}</a>) + punctuation.reverse.join('') + trailing_gt
+        end
+      end
+    end
+
+    def auto_link_email_addresses(text)
+      text.gsub(AUTO_EMAIL_RE) do
+        address = $&
+        if auto_linked?($`, $')
+          address
+        else
+          %(<a href="mailto:#{CGI.escapeHTML(address)}">#{address}</a>)
+        end
+      end
+    end
+
+    def auto_linked?(left, right)
+      (left =~ AUTO_LINK_CRE[0] and right =~ AUTO_LINK_CRE[1]) or
+        (left.rindex(AUTO_LINK_CRE[2]) and $' !~ AUTO_LINK_CRE[3])
+    end
+  end
+end
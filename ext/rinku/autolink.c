@@ -21,6 +21,7 @@
 
 #include "buffer.h"
 #include "autolink.h"
+#include "scan.h"
 #include "utf8.h"
 
 #if defined(_WIN32)
@@ -57,53 +58,91 @@ autolink_issafe(const uint8_t *link, size_t link_len)
 	return false;
 }
 
-static bool
-autolink_delim(const uint8_t *data, struct autolink_pos *link)
+/*
+ * Counts the brackets of every pair in the link, in a single pass
+ */
+static void
+autolink_count_brackets(const uint8_t *data, const struct autolink_pos *link,
+	size_t *opening, size_t *closing)
 {
-	int32_t cclose, copen = 0;
 	size_t i;
 
-	for (i = link->start; i < link->end; ++i)
-		if (data[i] == '<') {
-			link->end = i;
-			break;
+	for (i = link->start; i < link->end; ) {
+		size_t next = i;
+		int bracket;
+
+		if (data[i] < 0x80) {
+			bracket = utf8proc_bracket(data[i]);
+			next++;
+		} else {
+			bracket = utf8proc_bracket(utf8proc_next(data, &next));
+			if (next == i)
+				next++;
 		}
 
-	while (link->end > link->start) {
-		if (strchr("?!.,:", data[link->end - 1]) != NULL)
-			link->end--;
+		if (bracket > 0)
+			opening[bracket]++;
+		else if (bracket < 0)
+			closing[-bracket]++;
+
+		i = next;
+	}
+}
+
+/*
+ * Trims the end of a link: everything after a `<`, trailing punctuation
+ * and entities, quotes, and closing brackets that don't close anything.
+ * The brackets are counted once, the first time the link ends in one,
+ * so trimming never needs to look at the whole link again.
+ */
+static bool
+autolink_delim(const uint8_t *data, struct autolink_pos *link)
+{
+	size_t opening[UTF8PROC_BRACKET_PAIRS + 1] = {0};
+	size_t closing[UTF8PROC_BRACKET_PAIRS + 1] = {0};
+	bool counted = false;
+	const uint8_t *lt;
+
+	lt = memchr(data + link->start, '<', link->end - link->start);
+	if (lt)
+		link->end = lt - data;
+
+	for (;;) {
+		int32_t cclose;
+		int bracket;
 
-		else if (data[link->end - 1] == ';') {
-			size_t new_end = link->end - 2;
+		while (link->end > link->start) {
+			uint8_t c = data[link->end - 1];
 
-			while (new_end > 0 && rinku_isalnum(data[new_end]))
-				new_end--;
+			if (c == '?' || c == '!' || c == '.' || c == ',' || c == ':')
+				link->end--;
 
-			if (new_end < link->end - 2) {
-				if (new_end > 0 && data[new_end] == '#')
+			else if (c == ';') {
+				size_t new_end = link->end - 2;
+
+				while (new_end > link->start && rinku_isalnum(data[new_end]))
 					new_end--;
 
-				if (data[new_end] == '&') {
-					link->end = new_end;
-					continue;
+				if (new_end < link->end - 2) {
+					if (new_end > link->start && data[new_end] == '#')
+						new_end--;
+
+					if (data[new_end] == '&') {
+						link->end = new_end;
+						continue;
+					}
 				}
+				link->end--;
 			}
-			link->end--;
+			else break;
 		}
-		else break;
-	}
-
-	if (link->end == link->start)
-		return false;
 
-	cclose = utf8proc_rewind(data, link->end);
-	copen = utf8proc_open_paren_character(cclose);
+		if (link->end == link->start)
+			return false;
 
-	if (copen != 0) {
-		/* Try to close the final punctuation sign in this link; if
-		 * there's more closing than opening punctuation symbols in the
-		 * URL, we conservatively remove one closing punctuation from
-		 * the end of the URL.
+		/* Closing punctuation that isn't balanced within the link is
+		 * left out of it, one sign at a time. A quote can't be told
+		 * apart from the one opening it, so it is always left out.
 		 *
 		 * Examples:
 		 *
@@ -119,69 +158,92 @@ autolink_delim(const uint8_t *data, struct autolink_pos *link)
 		 *	(foo http://www.pokemon.com/Pikachu_(Electric)) bar
 		 *		=> http://www.pokemon.com/Pikachu_(Electric)
 		 */
+		cclose = utf8proc_rewind(data, link->end);
 
-		size_t closing = 0;
-		size_t opening = 0;
-		size_t i = link->start;
-
-		while (i < link->end) {
-			int32_t c = utf8proc_next(data, &i);
-			if (c == copen)
-				opening++;
-			else if (c == cclose)
-				closing++;
+		if (cclose == '"' || cclose == '\'') {
+			utf8proc_back(data, &link->end);
+			continue;
 		}
 
-		if (copen == cclose) {
-			if (opening > 0)
-				utf8proc_back(data, &link->end);
+		bracket = utf8proc_bracket(cclose);
+		if (bracket < 0 && !counted) {
+			/* nothing trimmed so far was a bracket */
+			autolink_count_brackets(data, link, opening, closing);
+			counted = true;
 		}
-		else {
-			if (closing > opening)
-				utf8proc_back(data, &link->end);
+
+		if (bracket < 0 && closing[-bracket] > opening[-bracket]) {
+			closing[-bracket]--;
+			utf8proc_back(data, &link->end);
+			continue;
 		}
-	}
 
-	return true;
+		return true;
+	}
 }
 
-static bool
-autolink_delim_iter(const uint8_t *data, struct autolink_pos *link)
+void
+autolink_memo_init(struct autolink_memo *memo)
 {
-	size_t prev_link_end;
-	int iterations = 0;
-
-	while(link->end != 0) {
-		prev_link_end = link->end;
-		if (!autolink_delim(data, link))
-			return false;
-		if (prev_link_end == link->end || iterations > 5) {
-			break;
-		}
-		iterations++;
-	}
-
-	return true;
+	memset(memo, 0x0, sizeof(*memo));
 }
 
 static bool
 check_domain(const uint8_t *data, size_t size,
-		struct autolink_pos *link, bool allow_short)
+		struct autolink_pos *link, bool allow_short,
+		struct autolink_memo *memo)
 {
-	size_t i, np = 0, uscore1 = 0, uscore2 = 0;
+	size_t i, np = 0, uscore1 = 0, uscore2 = 0, dot1 = 0, dot2 = 0;
 
 	if (!rinku_isalnum(data[link->start]))
 		return false;
 
-	for (i = link->start + 1; i < size - 1; ++i) {
-		if (data[i] == '_') {
-			uscore2++;
-		} else if (data[i] == '.') {
-			uscore1 = uscore2;
-			uscore2 = 0;
-			np++;
-		} else if (!is_valid_hostchar(data + i, size - i) && data[i] != '-')
-			break;
+	if (memo && link->start > memo->host_start &&
+		link->start < memo->host_dot) {
+		/* Same walk as last time, with at least the same last two
+		 * dots ahead of us; `www.www.www...` stays linear */
+		i = memo->host_end;
+		np = 2;
+		uscore1 = memo->uscore1;
+		uscore2 = memo->uscore2;
+	} else {
+		for (i = link->start + 1; i < size - 1; ++i) {
+			uint8_t c = data[i];
+
+			if (c < 0x80) {
+				uint16_t cls = rinku_char_class[c];
+
+				if (cls & RINKU_CHAR_HOST_END)
+					break;
+
+				if (cls & RINKU_CHAR_HOST_USCORE) {
+					uscore2++;
+				} else if (cls & RINKU_CHAR_HOST_DOT) {
+					uscore1 = uscore2;
+					uscore2 = 0;
+					dot2 = dot1;
+					dot1 = i;
+					np++;
+				}
+				continue;
+			}
+
+			if (!is_valid_hostchar(data + i, size - i))
+				break;
+
+			/* Only the first byte of a codepoint can end the host;
+			 * skip the rest of it in one go */
+			while (i + 1 < size - 1 && (data[i + 1] & 0xC0) == 0x80)
+				i++;
+		}
+
+		if (memo) {
+			memo->host_start = link->start;
+			memo->host_end = i;
+			memo->host_dot = dot2;
+			memo->uscore1 = uscore1;
+			memo->uscore2 = uscore2;
+		}
 	}
 
 	if (uscore1 > 0 || uscore2 > 0)
@@ -202,13 +264,49 @@ check_domain(const uint8_t *data, size_t size,
 	}
 }
 
+/* What ends a link, and the non-ASCII bytes that might */
+static const struct scan_set link_end_set = {
+	.table = { ['\t'] = 1, ['\n'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1, ['<'] = 1 },
+	.bytes = { '\t', '\n', '\f', '\r', ' ', '<', '\t', '\t' },
+	.count = 6,
+	.high = 0x80,
+};
+
+/*
+ * Finds where a link that starts before `pos` stops: at the first space,
+ * or at the first `<`, where autolink_delim would cut it anyway. Stopping
+ * at the `<` keeps every link in a text without spaces from walking all
+ * the way to its end. Codepoints are only decoded where the text isn't
+ * ASCII.
+ */
+static size_t
+find_link_end(const uint8_t *data, size_t pos, size_t size)
+{
+	while ((pos = scan_find(&link_end_set, data, pos, size)) < size) {
+		const size_t last = pos;
+		int32_t uc;
+
+		/* a `<` or an ASCII space */
+		if (data[pos] < 0x80)
+			return pos;
+
+		uc = utf8proc_next(data, &pos);
+		if (uc == 0xFFFD)
+			return size;
+		else if (utf8proc_is_space(uc))
+			return last;
+	}
+	return size;
+}
+
 bool
 autolink__www(
 	struct autolink_pos *link,
 	const uint8_t *data,
 	size_t pos,
 	size_t size,
-	unsigned int flags)
+	unsigned int flags,
+	struct autolink_memo *memo)
 {
 	int32_t boundary;
 	assert(data[pos] == 'w' || data[pos] == 'W');
@@ -228,11 +326,11 @@ autolink__www(
 	link->start = pos;
 	link->end = 0;
 
-	if (!check_domain(data, size, link, false))
+	if (!check_domain(data, size, link, false, memo))
 		return false;
 
-	link->end = utf8proc_find_space(data, link->end, size);
-	return autolink_delim_iter(data, link);
+	link->end = find_link_end(data, link->end, size);
+	return autolink_delim(data, link);
 }
 
 bool
@@ -241,7 +339,8 @@ autolink__email(
 	const uint8_t *data,
 	size_t pos,
 	size_t size,
-	unsigned int flags)
+	unsigned int flags,
+	struct autolink_memo *memo)
 {
 	int nb = 0, np = 0;
 	assert(data[pos] == '@');
@@ -250,15 +349,8 @@ autolink__email(
 	link->end = pos;
 
 	for (; link->start > 0; link->start--) {
-		uint8_t c = data[link->start - 1];
-
-		if (rinku_isalnum(c))
-			continue;
-
-		if (strchr(".+-_%", c) != NULL)
-			continue;
-
-		break;
+		if (!(rinku_char_class[data[link->start - 1]] & RINKU_CHAR_EMAIL))
+			break;
 	}
 
 	if (link->start == pos)
@@ -270,9 +362,12 @@ autolink__email(
 		if (rinku_isalnum(c))
 			continue;
 
-		if (c == '@')
-			nb++;
-		else if (c == '.' && link->end < size - 1)
+		if (c == '@') {
+			/* a second `@` can never be part of the address;
+			 * don't walk the rest of `a@a@a@...` for each of them */
+			if (nb++ > 0)
+				return false;
+		} else if (c == '.' && link->end < size - 1)
 			np++;
 		else if (c != '-' && c != '_')
 			break;
@@ -290,7 +385,8 @@ autolink__url(
 	const uint8_t *data,
 	size_t pos,
 	size_t size,
-	unsigned int flags)
+	unsigned int flags,
+	struct autolink_memo *memo)
 {
 	assert(data[pos] == ':');
 
@@ -300,17 +396,20 @@ autolink__url(
 	link->start = pos + 3;
 	link->end = 0;
 
-	if (!check_domain(data, size, link, flags & AUTOLINK_SHORT_DOMAINS))
+	if (!check_domain(data, size, link,
+			flags & AUTOLINK_SHORT_DOMAINS, memo))
 		return false;
 
 	link->start = pos;
-	link->end = utf8proc_find_space(data, link->end, size);
 
 	while (link->start && rinku_isalpha(data[link->start - 1]))
 		link->start--;
 
+	/* before looking for the end, which may be far away */
 	if (!autolink_issafe(data + link->start, size - link->start))
 		return false;
 
-	return autolink_delim_iter(data, link);
+	link->end = find_link_end(data, link->end, size);
+
+	return autolink_delim(data, link);
 }
@@ -33,20 +33,37 @@ struct autolink_pos {
 	size_t end;
 };
 
+/* struct autolink_memo: the last hostname check_domain walked through,
+ * so that the triggers inside one long hostname don't walk it again
+ * each. Only valid while scanning a single text front to back. */
+struct autolink_memo {
+	size_t host_start;
+	size_t host_end;
+	size_t host_dot;	/* second to last dot in the hostname, or 0 */
+	size_t uscore1;		/* underscores between the last two dots */
+	size_t uscore2;		/* underscores after the last dot */
+};
+
+void
+autolink_memo_init(struct autolink_memo *memo);
+
 bool
 autolink_issafe(const uint8_t *link, size_t link_len);
 
 bool
 autolink__www(struct autolink_pos *res,
-	const uint8_t *data, size_t pos, size_t size, unsigned int flags);
+	const uint8_t *data, size_t pos, size_t size, unsigned int flags,
+	struct autolink_memo *memo);
 
 bool
 autolink__email(struct autolink_pos *res,
-	const uint8_t *data, size_t pos, size_t size, unsigned int flags);
+	const uint8_t *data, size_t pos, size_t size, unsigned int flags,
+	struct autolink_memo *memo);
 
 bool
 autolink__url(struct autolink_pos *res,
-	const uint8_t *data, size_t pos, size_t size, unsigned int flags);
+	const uint8_t *data, size_t pos, size_t size, unsigned int flags,
+	struct autolink_memo *memo);
 
 #ifdef __cplusplus
 }
@@ -63,9 +63,16 @@ bufgrow(struct buf *buf, size_t neosz)
 	if (buf->asize >= neosz)
 		return BUF_OK;
 
-	neoasz = buf->asize + buf->unit;
+	/* grow geometrically, so appending N bytes is amortized O(N) */
+	neoasz = buf->asize ? buf->asize : buf->unit;
 	while (neoasz < neosz)
-		neoasz += buf->unit;
+		neoasz *= 2;
+
+	if (neoasz > BUFFER_MAX_ALLOC_SIZE)
+		neoasz = BUFFER_MAX_ALLOC_SIZE;
+
+	if (buf->grow)
+		return buf->grow(buf, neoasz);
 
 	neodata = realloc(buf->data, neoasz);
 	if (!neodata)
@@ -88,6 +95,8 @@ bufnew(size_t unit)
 		ret->data = 0;
 		ret->size = ret->asize = 0;
 		ret->unit = unit;
+		ret->grow = NULL;
+		ret->opaque = NULL;
 	}
 	return ret;
 }
@@ -191,7 +200,8 @@ bufrelease(struct buf *buf)
 	if (!buf)
 		return;
 
-	free(buf->data);
+	if (!buf->grow)
+		free(buf->data);
 	free(buf);
 }
 
@@ -203,7 +213,8 @@ bufreset(struct buf *buf)
 	if (!buf)
 		return;
 
-	free(buf->data);
+	if (!buf->grow)
+		free(buf->data);
 	buf->data = NULL;
 	buf->size = buf->asize = 0;
 }
@@ -41,16 +41,21 @@ struct buf {
 	uint8_t *data;		/* actual character data */
 	size_t size;	/* size of the string */
 	size_t asize;	/* allocated size (0 = volatile buffer) */
-	size_t unit;	/* reallocation unit size (0 = read-only buffer) */
+	size_t unit;	/* first allocation size (0 = read-only buffer) */
+
+	/* custom allocator: must make room for at least the given size and
+	 * update `data` and `asize` (NULL = realloc) */
+	int (*grow)(struct buf *, size_t);
+	void *opaque;	/* data for the custom allocator */
 };
 
 /* CONST_BUF: global buffer from a string litteral */
 #define BUF_STATIC(string) \
-	{ (uint8_t *)string, sizeof string -1, sizeof string, 0, 0 }
+	{ (uint8_t *)string, sizeof string -1, sizeof string, 0, NULL, NULL }
 
 /* VOLATILE_BUF: macro for creating a volatile buffer on the stack */
 #define BUF_VOLATILE(strname) \
-	{ (uint8_t *)strname, strlen(strname), 0, 0, 0 }
+	{ (uint8_t *)strname, strlen(strname), 0, 0, NULL, NULL }
 
 /* BUFPUTSL: optimized bufputs of a string litteral */
 #define BUFPUTSL(output, literal) \
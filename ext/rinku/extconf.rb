@@ -2,5 +2,7 @@ require 'mkmf'
 
 $CFLAGS += ' -fvisibility=hidden'
 
+have_header('pthread.h')
+
 dir_config('rinku')
 create_makefile('rinku')
@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <string.h>
+#include <assert.h>
+
+#include "html.h"
+#include "utf8.h"
+
+enum {
+	HTML_TEXT = 0,
+	HTML_TAG_OPEN,		/* after `<` */
+	HTML_END_TAG_OPEN,	/* after `</` */
+	HTML_TAG_NAME,
+	HTML_ATTRS,		/* anywhere in a tag after its name */
+	HTML_ATTR_VALUE,	/* after `=`, before the value */
+	HTML_ATTR_QUOTED,	/* inside a quoted value */
+	HTML_DECL,		/* after `<!` */
+	HTML_DECL_COMMENT,	/* after `<!-` */
+	HTML_DECL_CDATA,	/* somewhere in `<![CDATA[` */
+	HTML_COMMENT_START,	/* right after `<!--` */
+	HTML_COMMENT_START_DASH,/* right after `<!---` */
+	HTML_COMMENT,
+	HTML_CDATA,
+	HTML_BOGUS,		/* `<?`, `<!` or a closing tag, until `>` */
+	HTML_SKIP,		/* in the body of a skipped element */
+	HTML_SKIP_LT,		/* after a `<` in the body */
+	HTML_SKIP_END,		/* somewhere in the `</name` closing it */
+};
+
+static const char CDATA_OPEN[] = "[CDATA[";
+
+static bool
+html_isalpha(uint8_t c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static uint32_t
+html_tag_hash(uint32_t seed, const uint8_t *name, size_t len)
+{
+	uint32_t hash = 2166136261u ^ seed;
+	size_t i;
+
+	for (i = 0; i < len; ++i) {
+		hash ^= name[i];
+		hash *= 16777619u;
+	}
+
+	return (hash ^ (hash >> 16)) & (HTML_TAGSET_SLOTS - 1);
+}
+
+static bool
+html_tagset_build(struct html_tagset *set, uint32_t seed)
+{
+	size_t i;
+
+	memset(set->slots, 0x0, sizeof(set->slots));
+	set->seed = seed;
+
+	for (i = 0; set->names[i] != NULL; ++i) {
+		const char *name = set->names[i];
+		size_t len = strlen(name);
+		uint32_t slot;
+
+		if (len == 0 || len > HTML_TAG_NAME_MAX)
+			continue;
+
+		slot = html_tag_hash(seed, (const uint8_t *)name, len);
+
+		if (set->slots[slot]) {
+			/* a repeated name is fine; any other name is not */
+			if (strcmp(set->names[set->slots[slot] - 1], name) != 0)
+				return false;
+			continue;
+		}
+
+		set->slots[slot] = (uint8_t)(i + 1);
+	}
+
+	return true;
+}
+
+void
+html_tagset_init(struct html_tagset *set, const char **names)
+{
+	uint32_t seed;
+	size_t count = 0;
+
+	set->names = names;
+	set->linear = true;
+
+	while (names[count] != NULL)
+		count++;
+
+	/* Up to half full, a perfect seed shows up within a few tries */
+	if (count > HTML_TAGSET_SLOTS / 2)
+		return;
+
+	for (seed = 0; seed < 256; ++seed) {
+		if (html_tagset_build(set, seed)) {
+			set->linear = false;
+			return;
+		}
+	}
+}
+
+int
+html_tagset_find(const struct html_tagset *set,
+	const uint8_t *name, size_t name_len)
+{
+	const char *candidate;
+	int i;
+
+	if (name_len == 0 || name_len > HTML_TAG_NAME_MAX)
+		return -1;
+
+	if (set->linear) {
+		for (i = 0; set->names[i] != NULL; ++i) {
+			candidate = set->names[i];
+
+			if (strlen(candidate) == name_len &&
+				memcmp(candidate, name, name_len) == 0)
+				return i;
+		}
+
+		return -1;
+	}
+
+	i = set->slots[html_tag_hash(set->seed, name, name_len)] - 1;
+	if (i < 0)
+		return -1;
+
+	candidate = set->names[i];
+	if (strlen(candidate) != name_len || memcmp(candidate, name, name_len) != 0)
+		return -1;
+
+	return i;
+}
+
+void
+html_tokenizer_init(struct html_tokenizer *tok,
+	const struct html_tagset *skip)
+{
+	tok->skip = skip;
+	tok->state = HTML_TEXT;
+	tok->tag = -1;
+	tok->match = 0;
+	tok->quote = 0;
+	tok->closing = false;
+	tok->slash = false;
+	tok->name_len = 0;
+}
+
+bool
+html_tokenizer_done(const struct html_tokenizer *tok)
+{
+	return tok->state == HTML_TEXT;
+}
+
+static size_t
+html_done(struct html_tokenizer *tok, size_t consumed)
+{
+	html_tokenizer_init(tok, tok->skip);
+	return consumed;
+}
+
+/*
+ * Looks for the end of a comment or CDATA section: two or more `dash`
+ * followed by `>`. Returns the position after the `>`, or `size`.
+ */
+static size_t
+html_find_close(struct html_tokenizer *tok,
+	const uint8_t *data, size_t i, size_t size, uint8_t dash)
+{
+	while (i < size) {
+		if (tok->match == 0) {
+			const uint8_t *next = memchr(data + i, dash, size - i);
+			if (!next)
+				return size;
+
+			i = next - data;
+		}
+
+		if (data[i] == dash) {
+			if (tok->match < 2)
+				tok->match++;
+		} else if (data[i] == '>' && tok->match == 2) {
+			tok->state = HTML_TEXT;
+			return i + 1;
+		} else {
+			tok->match = 0;
+		}
+
+		i++;
+	}
+
+	return size;
+}
+
+size_t
+html_skip(struct html_tokenizer *tok, const uint8_t *data, size_t size)
+{
+	const uint8_t *next;
+	size_t i = 0;
+
+	while (i < size) {
+		uint8_t c = data[i];
+
+		switch (tok->state) {
+		case HTML_TEXT:
+			assert(c == '<');
+			tok->state = HTML_TAG_OPEN;
+			i++;
+			break;
+
+		case HTML_TAG_OPEN:
+			if (c == '!') {
+				tok->state = HTML_DECL;
+				i++;
+			} else if (c == '/') {
+				tok->closing = true;
+				tok->state = HTML_END_TAG_OPEN;
+				i++;
+			} else if (c == '?') {
+				tok->state = HTML_BOGUS;
+				i++;
+			} else if (html_isalpha(c)) {
+				tok->state = HTML_TAG_NAME;
+			} else {
+				/* a lone `<` is just text */
+				return html_done(tok, i);
+			}
+			break;
+
+		case HTML_END_TAG_OPEN:
+			if (c == '>')
+				return html_done(tok, i + 1);
+
+			tok->state = html_isalpha(c) ? HTML_TAG_NAME : HTML_BOGUS;
+			break;
+
+		case HTML_TAG_NAME:
+			while (i < size && data[i] != '>' && data[i] != '/' &&
+				!rinku_isspace(data[i])) {
+				if (tok->name_len < HTML_TAG_NAME_MAX)
+					tok->name[tok->name_len] = data[i];
+				tok->name_len++;
+				i++;
+			}
+
+			if (i < size) {
+				if (!tok->closing && tok->skip)
+					tok->tag = html_tagset_find(tok->skip,
+						tok->name, tok->name_len);
+				tok->state = HTML_ATTRS;
+			}
+			break;
+
+		case HTML_ATTRS:
+			while (i < size && data[i] != '>' && data[i] != '=') {
+				tok->slash = (data[i] == '/');
+				i++;
+			}
+
+			if (i == size)
+				break;
+
+			if (data[i] == '=') {
+				tok->slash = false;
+				tok->state = HTML_ATTR_VALUE;
+				i++;
+			} else if (tok->tag >= 0 && !tok->slash) {
+				/* unless it was self-closed, like `<pre/>` */
+				tok->state = HTML_SKIP;
+				i++;
+			} else {
+				return html_done(tok, i + 1);
+			}
+			break;
+
+		case HTML_ATTR_VALUE:
+			if (c == '"' || c == '\'') {
+				tok->quote = c;
+				tok->state = HTML_ATTR_QUOTED;
+				i++;
+			} else if (rinku_isspace(c)) {
+				i++;
+			} else {
+				tok->state = HTML_ATTRS;
+			}
+			break;
+
+		case HTML_ATTR_QUOTED:
+			next = memchr(data + i, tok->quote, size - i);
+			if (!next)
+				return size;
+
+			tok->state = HTML_ATTRS;
+			i = next - data + 1;
+			break;
+
+		case HTML_DECL:
+			if (c == '-') {
+				tok->state = HTML_DECL_COMMENT;
+				i++;
+			} else if (c == '[') {
+				tok->state = HTML_DECL_CDATA;
+				tok->match = 1;
+				i++;
+			} else {
+				tok->state = HTML_BOGUS;
+			}
+			break;
+
+		case HTML_DECL_COMMENT:
+			if (c == '-') {
+				tok->state = HTML_COMMENT_START;
+				i++;
+			} else {
+				tok->state = HTML_BOGUS;
+			}
+			break;
+
+		case HTML_DECL_CDATA:
+			if (c != (uint8_t)CDATA_OPEN[tok->match]) {
+				tok->state = HTML_BOGUS;
+				break;
+			}
+
+			i++;
+			if (++tok->match == sizeof(CDATA_OPEN) - 1) {
+				tok->state = HTML_CDATA;
+				tok->match = 0;
+			}
+			break;
+
+		case HTML_COMMENT_START:
+			if (c == '>')
+				return html_done(tok, i + 1);
+
+			if (c == '-') {
+				tok->state = HTML_COMMENT_START_DASH;
+				i++;
+			} else {
+				tok->state = HTML_COMMENT;
+				tok->match = 0;
+			}
+			break;
+
+		case HTML_COMMENT_START_DASH:
+			if (c == '>')
+				return html_done(tok, i + 1);
+
+			tok->state = HTML_COMMENT;
+			tok->match = 1;
+			break;
+
+		case HTML_COMMENT:
+		case HTML_CDATA:
+			i = html_find_close(tok, data, i, size,
+				tok->state == HTML_COMMENT ? '-' : ']');
+
+			if (tok->state == HTML_TEXT)
+				return html_done(tok, i);
+			break;
+
+		case HTML_BOGUS:
+			next = memchr(data + i, '>', size - i);
+			if (!next)
+				return size;
+
+			return html_done(tok, next - data + 1);
+
+		case HTML_SKIP:
+			next = memchr(data + i, '<', size - i);
+			if (!next)
+				return size;
+
+			tok->state = HTML_SKIP_LT;
+			i = next - data + 1;
+			break;
+
+		case HTML_SKIP_LT:
+			if (c == '/') {
+				tok->state = HTML_SKIP_END;
+				tok->match = 0;
+				i++;
+			} else {
+				tok->state = HTML_SKIP;
+			}
+			break;
+
+		case HTML_SKIP_END: {
+			const char *name = tok->skip->names[tok->tag];
+
+			if (name[tok->match] != 0) {
+				if (c == (uint8_t)name[tok->match]) {
+					tok->match++;
+					i++;
+				} else {
+					tok->state = HTML_SKIP;
+				}
+			} else if (c == '>') {
+				return html_done(tok, i + 1);
+			} else if (rinku_isspace(c)) {
+				tok->state = HTML_BOGUS;
+			} else {
+				tok->state = HTML_SKIP;
+			}
+			break;
+		}
+		}
+	}
+
+	return size;
+}
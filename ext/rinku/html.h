@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef RINKU_HTML_H
+#define RINKU_HTML_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTML_TAGSET_SLOTS 256
+#define HTML_TAG_NAME_MAX 64
+
+/* struct html_tagset: perfect hash of the names of the skipped tags */
+struct html_tagset {
+	const char **names;
+	uint8_t slots[HTML_TAGSET_SLOTS];	/* index + 1 into `names`, or 0 */
+	uint32_t seed;
+	bool linear;		/* no perfect hash found; search `names` */
+};
+
+/* html_tagset_init: builds the set from a NULL-terminated list of tag
+ * names, which must outlive the set. Names longer than
+ * HTML_TAG_NAME_MAX can never match. */
+void html_tagset_init(struct html_tagset *set, const char **names);
+
+/* html_tagset_find: index of the given name in the set, or -1 */
+int html_tagset_find(const struct html_tagset *set,
+	const uint8_t *name, size_t name_len);
+
+/* struct html_tokenizer: position of the tokenizer inside a piece of
+ * markup; it can be fed the markup in as many chunks as needed */
+struct html_tokenizer {
+	const struct html_tagset *skip;
+	int state;
+	int tag;		/* skipped element we are in, or -1 */
+	size_t match;		/* bytes of the current delimiter seen so far */
+	uint8_t quote;
+	bool closing;
+	bool slash;		/* the last byte of the tag was a `/` */
+	size_t name_len;
+	uint8_t name[HTML_TAG_NAME_MAX];
+};
+
+void html_tokenizer_init(struct html_tokenizer *tok,
+	const struct html_tagset *skip);
+
+/* html_tokenizer_done: true when the tokenizer is not inside markup */
+bool html_tokenizer_done(const struct html_tokenizer *tok);
+
+/* html_skip: consumes markup, which must start with `<` if the tokenizer
+ * is done, until the tag, comment or skipped element ends. Returns how
+ * many bytes belong to the markup; if the tokenizer is not done
+ * afterwards, all of them did and the markup continues in the next
+ * chunk. A `<` that does not start markup is consumed on its own. */
+size_t html_skip(struct html_tokenizer *tok, const uint8_t *data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* vim: set filetype=c: */
@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "policy.h"
+#include "utf8.h"
+
+/* The longest label and domain name DNS allows */
+#define POLICY_LABEL_MAX 63
+#define POLICY_DOMAIN_MAX 253
+
+/* An edge of the trie, from `parent` to `child` through a label; the
+ * slot is free when `child` is 0, which is always the root */
+struct policy_edge {
+	uint32_t hash;
+	uint32_t parent;
+	uint32_t child;
+	uint32_t label_len;
+	size_t label;		/* offset into `labels` */
+};
+
+static inline uint8_t
+policy_lower(uint8_t c)
+{
+	return (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+}
+
+/*
+ * Finds the start of the last label in `[start, end)` and hashes it,
+ * right to left, along the way
+ */
+static const uint8_t *
+policy_label(const uint8_t *start, const uint8_t *end, uint32_t parent,
+	uint32_t *hash)
+{
+	uint32_t h = 2166136261u ^ parent;
+
+	while (end > start && end[-1] != '.') {
+		h ^= policy_lower(*--end);
+		h *= 16777619u;
+	}
+
+	*hash = h;
+	return end;
+}
+
+/* The slot of the edge from `parent` through `label`: either that edge,
+ * or the free slot where it would go */
+static struct policy_edge *
+policy_slot(const struct rinku_policy *policy, uint32_t parent,
+	const uint8_t *label, size_t len, uint32_t hash)
+{
+	size_t i = hash & policy->edge_mask;
+
+	for (;; i = (i + 1) & policy->edge_mask) {
+		struct policy_edge *edge = &policy->edges[i];
+		const uint8_t *stored;
+		size_t j;
+
+		if (edge->child == 0)
+			return edge;
+
+		if (edge->hash != hash || edge->parent != parent ||
+			edge->label_len != len)
+			continue;
+
+		stored = policy->labels.data + edge->label;
+		for (j = 0; j < len; ++j) {
+			if (stored[j] != policy_lower(label[j]))
+				break;
+		}
+
+		if (j == len)
+			return edge;
+	}
+}
+
+static int
+policy_rehash(struct rinku_policy *policy)
+{
+	size_t i, capa = policy->edges ? (policy->edge_mask + 1) * 2 : 64;
+	struct policy_edge *old = policy->edges;
+	size_t old_capa = old ? policy->edge_mask + 1 : 0;
+
+	policy->edges = calloc(capa, sizeof(*policy->edges));
+	if (!policy->edges) {
+		policy->edges = old;
+		return -1;
+	}
+
+	policy->edge_mask = capa - 1;
+
+	for (i = 0; i < old_capa; ++i) {
+		size_t j;
+
+		if (old[i].child == 0)
+			continue;
+
+		for (j = old[i].hash & policy->edge_mask;
+			policy->edges[j].child != 0;
+			j = (j + 1) & policy->edge_mask)
+			;
+
+		policy->edges[j] = old[i];
+	}
+
+	free(old);
+	return 0;
+}
+
+/* The child of `parent` through `label`, added if it's not there yet;
+ * 0 if out of memory */
+static uint32_t
+policy_child(struct rinku_policy *policy, uint32_t parent,
+	const char *label, size_t len, uint32_t hash)
+{
+	struct policy_edge *edge;
+	size_t i;
+
+	/* at most 3/4 full */
+	if ((policy->edge_count + 1) * 4 > (policy->edge_mask + 1) * 3 &&
+		policy_rehash(policy) < 0)
+		return 0;
+
+	edge = policy_slot(policy, parent, (const uint8_t *)label, len, hash);
+	if (edge->child != 0)
+		return edge->child;
+
+	if ((policy->node_count & (policy->node_count - 1)) == 0) {
+		uint32_t *nodes = realloc(policy->node_rules,
+			policy->node_count * 2 * sizeof(*nodes));
+
+		if (!nodes)
+			return 0;
+		policy->node_rules = nodes;
+	}
+
+	if (bufgrow(&policy->labels, policy->labels.size + len) != BUF_OK)
+		return 0;
+
+	edge->hash = hash;
+	edge->parent = parent;
+	edge->label = policy->labels.size;
+	edge->label_len = (uint32_t)len;
+
+	for (i = 0; i < len; ++i)
+		bufputc(&policy->labels, policy_lower(label[i]));
+
+	policy->node_rules[policy->node_count] = 0;
+	edge->child = (uint32_t)policy->node_count++;
+	policy->edge_count++;
+	return edge->child;
+}
+
+static bool
+policy_label_valid(const char *label, size_t len)
+{
+	size_t i;
+
+	if (len == 0 || len > POLICY_LABEL_MAX)
+		return false;
+
+	for (i = 0; i < len; ++i) {
+		if (!rinku_isalnum(label[i]) && label[i] != '-' &&
+			label[i] != '_' && (uint8_t)label[i] < 0x80)
+			return false;
+	}
+
+	return true;
+}
+
+void
+rinku_policy_init(struct rinku_policy *policy)
+{
+	memset(policy, 0x0, sizeof(*policy));
+	policy->labels.unit = 1024;
+	policy->attrs.unit = 256;
+}
+
+int
+rinku_policy_add(struct rinku_policy *policy,
+	const char *domain, size_t size,
+	rinku_policy_action action, const char *attrs, size_t attr_len)
+{
+	struct rinku_policy_rule *rule;
+	uint32_t node = 0;
+
+	/* the root, which every host is under */
+	if (policy->node_rules == NULL) {
+		policy->node_rules = malloc(sizeof(*policy->node_rules));
+		if (!policy->node_rules)
+			return -1;
+
+		policy->node_rules[0] = 0;
+		policy->node_count = 1;
+	}
+
+	if (size == 1 && domain[0] == '*') {
+		size = 0;
+	} else {
+		if (size >= 2 && domain[0] == '*' && domain[1] == '.') {
+			domain += 2;
+			size -= 2;
+		} else if (size > 0 && domain[0] == '.') {
+			domain++;
+			size--;
+		}
+
+		if (size > 0 && domain[size - 1] == '.')
+			size--;
+
+		if (size == 0 || size > POLICY_DOMAIN_MAX)
+			return -2;
+	}
+
+	/* the labels, right to left */
+	while (size > 0) {
+		const char *dot;
+		uint32_t hash;
+		size_t len;
+
+		dot = (const char *)policy_label((const uint8_t *)domain,
+			(const uint8_t *)domain + size, node, &hash);
+
+		len = domain + size - dot;
+		if (!policy_label_valid(dot, len))
+			return -2;
+
+		if ((node = policy_child(policy, node, dot, len, hash)) == 0)
+			return -1;
+
+		if (dot == domain)
+			break;
+
+		size = dot - domain - 1;
+		if (size == 0)
+			return -2;
+	}
+
+	if (policy->node_rules[node] == 0) {
+		if ((policy->rule_count & (policy->rule_count - 1)) == 0) {
+			size_t capa = policy->rule_count ? policy->rule_count * 2 : 1;
+			struct rinku_policy_rule *rules = realloc(policy->rules,
+				capa * sizeof(*rules));
+
+			if (!rules)
+				return -1;
+			policy->rules = rules;
+		}
+
+		policy->node_rules[node] = (uint32_t)++policy->rule_count;
+	}
+
+	rule = &policy->rules[policy->node_rules[node] - 1];
+	rule->action = action;
+	rule->attr_offset = policy->attrs.size;
+	rule->attr_len = 0;
+
+	if (action == RINKU_POLICY_ATTRS) {
+		while (attr_len > 0 && rinku_isspace(*attrs)) {
+			attrs++;
+			attr_len--;
+		}
+
+		if (bufgrow(&policy->attrs, policy->attrs.size + attr_len) != BUF_OK)
+			return -1;
+
+		bufput(&policy->attrs, attrs, attr_len);
+		rule->attr_len = attr_len;
+	}
+
+	return 0;
+}
+
+const struct rinku_policy_rule *
+rinku_policy_match(const struct rinku_policy *policy,
+	const uint8_t *host, size_t size)
+{
+	const struct rinku_policy_rule *best = NULL;
+	uint32_t node = 0;
+
+	if (policy->node_count == 0)
+		return NULL;
+
+	if (policy->node_rules[0])
+		best = &policy->rules[policy->node_rules[0] - 1];
+
+	if (policy->edge_count == 0)
+		return best;
+
+	/* `example.com.` is `example.com` */
+	if (size > 0 && host[size - 1] == '.')
+		size--;
+
+	while (size > 0) {
+		const struct policy_edge *edge;
+		const uint8_t *dot;
+		uint32_t hash;
+
+		dot = policy_label(host, host + size, node, &hash);
+		edge = policy_slot(policy, node, dot, host + size - dot, hash);
+
+		if (edge->child == 0)
+			break;
+
+		node = edge->child;
+		if (policy->node_rules[node])
+			best = &policy->rules[policy->node_rules[node] - 1];
+
+		if (dot == host)
+			break;
+
+		size = dot - host - 1;
+	}
+
+	return best;
+}
+
+void
+rinku_policy_free(struct rinku_policy *policy)
+{
+	free(policy->edges);
+	free(policy->node_rules);
+	free(policy->rules);
+	bufreset(&policy->labels);
+	bufreset(&policy->attrs);
+	rinku_policy_init(policy);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef RINKU_POLICY_H
+#define RINKU_POLICY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What to do with the links to a domain */
+typedef enum {
+	RINKU_POLICY_LINK = 0,	/* link it as any other */
+	RINKU_POLICY_SKIP,	/* leave it as text */
+	RINKU_POLICY_ATTRS,	/* link it with the rule's own attributes */
+} rinku_policy_action;
+
+struct rinku_policy_rule {
+	rinku_policy_action action;
+	size_t attr_offset;	/* into `attrs` of the policy */
+	size_t attr_len;
+};
+
+struct policy_edge;
+
+/* struct rinku_policy: a set of rules for domains and all their
+ * subdomains. The labels of each domain are stored right to left in a
+ * trie, whose edges all live in a single hash table, so a host is
+ * matched with one lookup per label. */
+struct rinku_policy {
+	struct policy_edge *edges;
+	size_t edge_mask;		/* the table has edge_mask + 1 slots */
+	size_t edge_count;
+
+	uint32_t *node_rules;		/* rule of each node, plus one; 0 if none */
+	size_t node_count;
+
+	struct rinku_policy_rule *rules;
+	size_t rule_count;
+
+	struct buf labels;
+	struct buf attrs;
+};
+
+void
+rinku_policy_init(struct rinku_policy *policy);
+
+/* rinku_policy_add: adds a rule for `domain` and its subdomains; a
+ * leading `.` or `*.` is ignored, and `*` on its own is the rule for
+ * every host no other rule matches. `attrs` are the attributes of its
+ * links for RINKU_POLICY_ATTRS, and ignored otherwise. A later rule for
+ * the same domain replaces the earlier one. Returns 0; -1 if out of
+ * memory; or -2 if `domain` is not a valid domain name. */
+int
+rinku_policy_add(struct rinku_policy *policy,
+	const char *domain, size_t size,
+	rinku_policy_action action, const char *attrs, size_t attr_len);
+
+/* rinku_policy_match: the rule of the longest domain `host` is or is a
+ * subdomain of, ignoring case; or NULL if none applies */
+const struct rinku_policy_rule *
+rinku_policy_match(const struct rinku_policy *policy,
+	const uint8_t *host, size_t size);
+
+void
+rinku_policy_free(struct rinku_policy *policy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* vim: set filetype=c: */
@@ -17,18 +17,16 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
+#include <time.h>
 
 #include "rinku.h"
 #include "autolink.h"
 #include "buffer.h"
+#include "html.h"
+#include "scan.h"
 #include "utf8.h"
 
-typedef enum {
-	HTML_TAG_NONE = 0,
-	HTML_TAG_OPEN,
-	HTML_TAG_CLOSE,
-} html_tag;
-
+/* The values of RINKU_CHAR_TRIGGER in rinku_char_class */
 typedef enum {
 	AUTOLINK_ACTION_NONE = 0,
 	AUTOLINK_ACTION_WWW,
@@ -37,16 +35,36 @@ typedef enum {
 	AUTOLINK_ACTION_SKIP_TAG
 } autolink_action;
 
-typedef bool (*autolink_parse_cb)(
-	struct autolink_pos *, const uint8_t *, size_t, size_t, unsigned int);
+#if defined(__GNUC__)
+#	define RINKU_ALWAYS_INLINE inline __attribute__ ((always_inline))
+#else
+#	define RINKU_ALWAYS_INLINE inline
+#endif
 
-static autolink_parse_cb g_callbacks[] = {
-	NULL,
-	autolink__www,	/* 1 */
-	autolink__email,/* 2 */
-	autolink__url,	/* 3 */
+/* The bytes that start a look for a link, for each autolink_mode; their
+ * actions are in rinku_char_class */
+static const struct scan_set g_triggers[] = {
+	{ .table = { ['<'] = 1 },
+	  .bytes = { '<', '<', '<', '<', '<', '<', '<', '<' }, .count = 1 },
+	{ .table = { [':'] = 1, ['<'] = 1, ['W'] = 1, ['w'] = 1 },
+	  .bytes = { ':', '<', 'W', 'w', ':', ':', ':', ':' }, .count = 4 },
+	{ .table = { ['<'] = 1, ['@'] = 1 },
+	  .bytes = { '<', '@', '<', '<', '<', '<', '<', '<' }, .count = 2 },
+	{ .table = { [':'] = 1, ['<'] = 1, ['@'] = 1, ['W'] = 1, ['w'] = 1 },
+	  .bytes = { ':', '<', '@', 'W', 'w', ':', ':', ':' }, .count = 5 },
 };
 
+/* The bytes AUTOLINK_ESCAPE_HTML escapes */
+static const struct scan_set g_escaped = {
+	.table = { ['"'] = 1, ['&'] = 1, ['\''] = 1, ['<'] = 1, ['>'] = 1 },
+	.bytes = { '"', '&', '\'', '<', '>', '"', '"', '"' },
+	.count = 5,
+};
+
+/* Which of the specialized scanners in autolink_next to use */
+#define AUTOLINK_SCANNER(mode, flags) \
+	(((mode) & AUTOLINK_ALL) | (((flags) & AUTOLINK_SHORT_DOMAINS) ? 4 : 0))
+
 static const char *g_hrefs[] = {
 	NULL,
 	"<a href=\"http://",
@@ -54,6 +72,19 @@ static const char *g_hrefs[] = {
 	"<a href=\"",
 };
 
+static const size_t g_href_lens[] = {
+	0,
+	sizeof("<a href=\"http://") - 1,
+	sizeof("<a href=\"mailto:") - 1,
+	sizeof("<a href=\"") - 1,
+};
+
+/* What {href} puts in front of each kind of link, and what {kind} says */
+static const char *g_schemes[] = { NULL, "http://", "mailto:", "" };
+static const size_t g_scheme_lens[] = { 0, 7, 7, 0 };
+static const char *g_kinds[] = { NULL, "www", "email", "url" };
+static const size_t g_kind_lens[] = { 0, 3, 5, 3 };
+
 /*
  * Rinku assumes valid HTML encoding for all input, but there's still
  * the case where a link can contain a double quote `"` that allows XSS.
@@ -63,97 +94,954 @@ static const char *g_hrefs[] = {
  */
 static void print_link(struct buf *ob, const uint8_t *link, size_t size)
 {
-	size_t i = 0, org;
+	const uint8_t *end = link + size;
+
+	while (link < end) {
+		const uint8_t *quote = memchr(link, '"', end - link);
+
+		if (!quote) {
+			bufput(ob, link, end - link);
+			break;
+		}
+
+		bufput(ob, link, quote - link);
+		BUFPUTSL(ob, "&quot;");
+		link = quote + 1;
+	}
+}
+
+/* The template for a kind of link, or NULL for the built-in markup */
+static const struct rinku_template *
+link_template(const struct rinku_options *opts, autolink_action action)
+{
+	if (action == AUTOLINK_ACTION_EMAIL && opts->email_template)
+		return opts->email_template;
+
+	return opts->url_template;
+}
+
+/*
+ * Size of what `tpl` renders for a link; texts from a callback are
+ * counted with their original length
+ */
+static size_t
+template_link_size(const struct rinku_template *tpl, autolink_action action,
+	const uint8_t *link, size_t link_len)
+{
+	const uint8_t *end = link + link_len, *quote;
+	size_t i, head, tail, size = 0, href_len = g_scheme_lens[action] + link_len;
 
-	while (i < size) {
-		org = i;
+	for (quote = link; (quote = memchr(quote, '"', end - quote)) != NULL; quote++)
+		href_len += sizeof("&quot;") - 2;
 
-		while (i < size && link[i] != '"')
-			i++;
+	for (i = 0; i < tpl->count; ++i) {
+		const struct template_op *op = &tpl->ops[i];
 
-		if (i > org)
-			bufput(ob, link + org, i - org);
+		switch (op->code) {
+		case TEMPLATE_LITERAL:
+			size += op->length;
+			break;
+		case TEMPLATE_HREF:
+			size += href_len;
+			break;
+		case TEMPLATE_TEXT:
+			if (rinku_template_shorten(link, link_len, op->length, &head, &tail))
+				size += head + sizeof(TEMPLATE_ELLIPSIS) - 1 + (link_len - tail);
+			else
+				size += link_len;
+			break;
+		case TEMPLATE_KIND:
+			size += g_kind_lens[action];
+			break;
+		}
+	}
 
-		if (i >= size)
+	return size;
+}
+
+static void
+template_render(struct buf *ob, const struct rinku_template *tpl,
+	autolink_action action, const uint8_t *link, size_t link_len,
+	const struct rinku_options *opts)
+{
+	size_t i, head, tail;
+
+	for (i = 0; i < tpl->count; ++i) {
+		const struct template_op *op = &tpl->ops[i];
+
+		switch (op->code) {
+		case TEMPLATE_LITERAL:
+			bufput(ob, tpl->literals.data + op->offset, op->length);
 			break;
 
-		BUFPUTSL(ob, "&quot;");
-		i++;
+		case TEMPLATE_HREF:
+			bufput(ob, g_schemes[action], g_scheme_lens[action]);
+			print_link(ob, link, link_len);
+			break;
+
+		case TEMPLATE_TEXT:
+			if (opts->link_text_cb) {
+				opts->link_text_cb(ob, link, link_len, opts->payload);
+			} else if (rinku_template_shorten(link, link_len, op->length, &head, &tail)) {
+				bufput(ob, link, head);
+				BUFPUTSL(ob, TEMPLATE_ELLIPSIS);
+				bufput(ob, link + tail, link_len - tail);
+			} else {
+				bufput(ob, link, link_len);
+			}
+			break;
+
+		case TEMPLATE_KIND:
+			bufput(ob, g_kinds[action], g_kind_lens[action]);
+			break;
+		}
+	}
+}
+
+/*
+ * The host of a link: what comes after its scheme, its user or the `@`
+ * of an address, and before its port or path
+ */
+static const uint8_t *
+link_host(autolink_action action, const uint8_t *link, size_t link_len,
+	size_t *host_len)
+{
+	const uint8_t *end = link + link_len, *host = link, *p;
+
+	if (action == AUTOLINK_ACTION_URL) {
+		const uint8_t *colon = memchr(link, ':', link_len);
+
+		if (colon && end - colon >= 3)
+			host = colon + 3;
 	}
+
+	for (p = host; p < end && *p != '/' && *p != '?' && *p != '#'; ++p) {
+		if (*p == '@')
+			host = p + 1;
+	}
+
+	end = p;
+	for (p = host; p < end && *p != ':'; ++p)
+		;
+
+	*host_len = p - host;
+	return host;
+}
+
+/* The rule of the domain policy for a link, if there is one */
+static const struct rinku_policy_rule *
+link_rule(const struct rinku_options *opts, autolink_action action,
+	const uint8_t *link, size_t link_len)
+{
+	const uint8_t *host;
+	size_t host_len;
+
+	if (!opts->domains)
+		return NULL;
+
+	host = link_host(action, link, link_len, &host_len);
+	return rinku_policy_match(opts->domains, host, host_len);
 }
 
-/* From sundown/html/html.c */
+/* Everything between the href and the text of a link */
+static void
+link_close(struct buf *ob, const struct rinku_options *opts,
+	const struct rinku_compiled *cfg, const struct rinku_policy_rule *rule)
+{
+	if (rule && rule->action == RINKU_POLICY_ATTRS) {
+		BUFPUTSL(ob, "\" ");
+		bufput(ob, opts->domains->attrs.data + rule->attr_offset,
+			rule->attr_len);
+		bufputc(ob, '>');
+	} else {
+		bufput(ob, cfg->link_close.data, cfg->link_close.size);
+	}
+}
+
+/* How many times around the scan loop between two looks at the clock,
+ * when there is a time budget */
+#define AUTOLINK_CLOCK_EVERY 64
+
+enum {
+	/* copy the input to the output even if it has no links */
+	AUTOLINK_RUN_COPY_ALL = (1 << 0),
+	/* stop right before a tag that is not closed within the buffer */
+	AUTOLINK_RUN_PARTIAL = (1 << 1),
+};
+
+/*
+ * Compiles `opts` into `cfg`, writing over whatever `link_close` held
+ * but reusing its memory
+ */
 static int
-html_is_tag(const uint8_t *tag_data, size_t tag_size, const char *tagname)
+autolink_compile(struct rinku_compiled *cfg, const struct rinku_options *opts)
+{
+	const char *link_attr = opts->link_attr;
+
+	cfg->triggers = &g_triggers[opts->mode & AUTOLINK_ALL];
+	cfg->scanner = AUTOLINK_SCANNER(opts->mode, opts->flags);
+	html_tagset_init(&cfg->skip_set, opts->skip_tags);
+
+	/* Everything between the href and the link text: `">` or
+	 * `" attr>` */
+	cfg->link_close.size = 0;
+
+	if (link_attr != NULL) {
+		while (rinku_isspace(*link_attr))
+			link_attr++;
+	}
+
+	if (link_attr != NULL) {
+		size_t attr_len = strlen(link_attr);
+
+		if (bufgrow(&cfg->link_close, attr_len + 3) != BUF_OK)
+			return -1;
+
+		BUFPUTSL(&cfg->link_close, "\" ");
+		bufput(&cfg->link_close, link_attr, attr_len);
+		bufputc(&cfg->link_close, '>');
+	} else {
+		if (bufgrow(&cfg->link_close, 2) != BUF_OK)
+			return -1;
+
+		BUFPUTSL(&cfg->link_close, "\">");
+	}
+
+	return 0;
+}
+
+int
+rinku_compile(struct rinku_compiled *cfg, const struct rinku_options *opts)
+{
+	memset(&cfg->link_close, 0x0, sizeof(cfg->link_close));
+	cfg->link_close.unit = 16;
+
+	return autolink_compile(cfg, opts);
+}
+
+void
+rinku_compiled_free(struct rinku_compiled *cfg)
+{
+	bufreset(&cfg->link_close);
+}
+
+struct autolink_scanner {
+	const uint8_t *text;
+	size_t size;
+	const struct rinku_options *opts;
+	const struct rinku_compiled *cfg;
+	unsigned int run_flags;
+
+	size_t pos;		/* where the trigger scan resumes */
+	size_t last;		/* end of the last link found */
+	const struct rinku_policy_rule *rule;	/* ...and its domain's rule */
+	size_t stop;		/* where the scan stopped */
+	bool interrupted;
+	struct autolink_memo memo;
+	struct rinku_stats *stats;
+
+	size_t scan_limit;	/* triggers past this are not looked at */
+	size_t links;
+	uint64_t deadline;	/* clock_ns() at which to give up, or 0 */
+	unsigned int ticks;
+	bool truncated;		/* a budget ran out */
+};
+
+static uint64_t
+clock_ns(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+/* When a call with these options has to be done by */
+static uint64_t
+autolink_deadline(const struct rinku_options *opts)
+{
+	return opts->max_ns ? clock_ns() + opts->max_ns : 0;
+}
+
+static void
+autolink_scanner_init(struct autolink_scanner *sc,
+	const uint8_t *text, size_t size,
+	const struct rinku_options *opts,
+	const struct rinku_compiled *cfg,
+	unsigned int run_flags,
+	uint64_t deadline)
+{
+	sc->text = text;
+	sc->size = text ? size : 0;
+	sc->opts = opts;
+	sc->cfg = cfg;
+	sc->run_flags = run_flags;
+	sc->pos = sc->last = 0;
+	sc->rule = NULL;
+	sc->stop = sc->size;
+	sc->interrupted = false;
+	autolink_memo_init(&sc->memo);
+	sc->stats = opts->stats;
+
+	sc->scan_limit = sc->size;
+	if (opts->max_bytes && opts->max_bytes < sc->size)
+		sc->scan_limit = opts->max_bytes;
+
+	sc->links = 0;
+	sc->deadline = deadline;
+	sc->ticks = 0;
+	sc->truncated = false;
+}
+
+void
+rinku_stats_add(struct rinku_stats *total, const struct rinku_stats *stats)
 {
 	size_t i;
-	int closed = 0;
 
-	if (tag_size < 3 || tag_data[0] != '<')
-		return HTML_TAG_NONE;
+	total->calls += stats->calls;
+	total->bytes_scanned += stats->bytes_scanned;
+	total->markup += stats->markup;
+	total->markup_bytes += stats->markup_bytes;
+	total->output_bytes += stats->output_bytes;
+	total->reallocs += stats->reallocs;
+	total->truncated += stats->truncated;
 
-	i = 1;
+	for (i = 0; i < RINKU_STATS_PARSERS; ++i) {
+		total->triggers[i] += stats->triggers[i];
+		total->links[i] += stats->links[i];
+		total->parse_ns[i] += stats->parse_ns[i];
+	}
+}
+
+/*
+ * Runs the parser for a trigger. The checks each parser starts with are
+ * made here first, so the triggers that can't start a link (like most
+ * `w` in a text) don't cost a call.
+ */
+static RINKU_ALWAYS_INLINE bool
+autolink_call(autolink_action action, struct autolink_pos *link,
+	const uint8_t *text, size_t pos, size_t size,
+	const unsigned int mode, const unsigned int flags,
+	struct autolink_memo *memo)
+{
+	switch (action) {
+	case AUTOLINK_ACTION_WWW:
+		if (!(mode & AUTOLINK_URLS) || size - pos < 4 ||
+			(text[pos + 1] | 0x20) != 'w' ||
+			(text[pos + 2] | 0x20) != 'w' || text[pos + 3] != '.')
+			return false;
+
+		return autolink__www(link, text, pos, size, flags, memo);
 
-	if (tag_data[i] == '/') {
-		closed = 1;
-		i++;
+	case AUTOLINK_ACTION_EMAIL:
+		if (!(mode & AUTOLINK_EMAILS) || pos == 0 ||
+			!(rinku_char_class[text[pos - 1]] & RINKU_CHAR_EMAIL))
+			return false;
+
+		return autolink__email(link, text, pos, size, flags, memo);
+
+	case AUTOLINK_ACTION_URL:
+		if (!(mode & AUTOLINK_URLS) || size - pos < 4 ||
+			text[pos + 1] != '/' || text[pos + 2] != '/')
+			return false;
+
+		return autolink__url(link, text, pos, size, flags, memo);
+
+	default:
+		return false;
 	}
+}
+
+/* Same, keeping count if asked to */
+static RINKU_ALWAYS_INLINE bool
+autolink_parse(struct autolink_scanner *sc, autolink_action action,
+	struct autolink_pos *link, size_t pos,
+	const unsigned int mode, const unsigned int flags)
+{
+	struct rinku_stats *stats = sc->stats;
+	uint64_t started = 0;
+	bool found;
+
+	if (!stats)
+		return autolink_call(action, link, sc->text, pos, sc->size,
+			mode, flags, &sc->memo);
+
+	if (stats->timing)
+		started = clock_ns();
+
+	found = autolink_call(action, link, sc->text, pos, sc->size,
+		mode, flags, &sc->memo);
+
+	if (stats->timing)
+		stats->parse_ns[action - 1] += clock_ns() - started;
+
+	stats->triggers[action - 1]++;
+	return found;
+}
 
-	for (; i < tag_size; ++i, ++tagname) {
-		if (*tagname == 0)
+/*
+ * Finds the next link in the text, skipping over HTML tags, and returns
+ * which kind of link it is, or AUTOLINK_ACTION_NONE once there are no
+ * more links before `sc->stop`. `mode` and `flags` are constants in
+ * each of the copies autolink_next makes of this loop.
+ */
+static RINKU_ALWAYS_INLINE autolink_action
+autolink_scan(struct autolink_scanner *sc, struct autolink_pos *link,
+	const unsigned int mode, const unsigned int flags)
+{
+	const uint8_t *text = sc->text;
+	const size_t size = sc->size;
+	const struct scan_set *triggers = sc->cfg->triggers;
+	size_t end = sc->pos;
+
+	while (sc->last < size) {
+		autolink_action action;
+
+		if (sc->opts->interrupt && *sc->opts->interrupt) {
+			sc->interrupted = true;
 			break;
+		}
+
+		if (sc->deadline && ++sc->ticks % AUTOLINK_CLOCK_EVERY == 0 &&
+			clock_ns() >= sc->deadline) {
+			sc->truncated = true;
+			break;
+		}
+
+		/* the last link may have ended past the limit */
+		if (end < sc->scan_limit)
+			end = scan_find(triggers, text, end, sc->scan_limit);
+
+		if (end >= sc->scan_limit) {
+			sc->truncated = (sc->scan_limit < size);
+			break;
+		}
+
+		action = RINKU_CHAR_TRIGGER_OF(rinku_char_class[text[end]]);
+
+		if (action == AUTOLINK_ACTION_SKIP_TAG) {
+			struct html_tokenizer tok;
+			size_t tag_len;
+
+			html_tokenizer_init(&tok, &sc->cfg->skip_set);
+			tag_len = html_skip(&tok, text + end, size - end);
+
+			if (sc->stats) {
+				sc->stats->markup++;
+				sc->stats->markup_bytes += tag_len;
+			}
+
+			if (!html_tokenizer_done(&tok) &&
+				(sc->run_flags & AUTOLINK_RUN_PARTIAL)) {
+				sc->stop = end;
+				break;
+			}
+
+			end += tag_len;
+			continue;
+		}
+
+		if (autolink_parse(sc, action, link, end, mode, flags) &&
+			link->start >= sc->last) {
+			sc->rule = link_rule(sc->opts, action,
+				text + link->start, link->end - link->start);
+
+			/* a link to a skipped domain stays text, and so does
+			 * anything in it that looks like a link */
+			if (sc->rule && sc->rule->action == RINKU_POLICY_SKIP) {
+				end = sc->last = link->end;
+				continue;
+			}
+
+			if (sc->opts->max_links &&
+				sc->links == sc->opts->max_links) {
+				sc->truncated = true;
+				break;
+			}
 
-		if (tag_data[i] != *tagname)
-			return HTML_TAG_NONE;
+			sc->links++;
+
+			if (sc->stats)
+				sc->stats->links[action - 1]++;
+
+			sc->pos = sc->last = link->end;
+			return action;
+		}
+
+		end = end + 1;
+	}
+
+	sc->pos = end;
+	return AUTOLINK_ACTION_NONE;
+}
+
+#define AUTOLINK_SCAN_CASE(mode, flags) \
+	case AUTOLINK_SCANNER(mode, flags): \
+		return autolink_scan(sc, link, mode, flags)
+
+static autolink_action
+autolink_next(struct autolink_scanner *sc, struct autolink_pos *link)
+{
+	switch (sc->cfg->scanner) {
+	AUTOLINK_SCAN_CASE(0, 0);
+	AUTOLINK_SCAN_CASE(AUTOLINK_URLS, 0);
+	AUTOLINK_SCAN_CASE(AUTOLINK_EMAILS, 0);
+	AUTOLINK_SCAN_CASE(AUTOLINK_ALL, 0);
+	AUTOLINK_SCAN_CASE(0, AUTOLINK_SHORT_DOMAINS);
+	AUTOLINK_SCAN_CASE(AUTOLINK_URLS, AUTOLINK_SHORT_DOMAINS);
+	AUTOLINK_SCAN_CASE(AUTOLINK_EMAILS, AUTOLINK_SHORT_DOMAINS);
+	AUTOLINK_SCAN_CASE(AUTOLINK_ALL, AUTOLINK_SHORT_DOMAINS);
 	}
 
-	if (i == tag_size)
-		return HTML_TAG_NONE;
+	return AUTOLINK_ACTION_NONE;
+}
+
+static size_t
+autolink_link_size(
+	autolink_action action,
+	const uint8_t *link,
+	size_t link_len,
+	const struct rinku_options *opts,
+	const struct rinku_compiled *cfg,
+	const struct rinku_policy_rule *rule)
+{
+	const struct rinku_template *tpl = link_template(opts, action);
+	const uint8_t *end = link + link_len;
+	size_t size = g_href_lens[action] + 2 * link_len;
 
-	if (rinku_isspace(tag_data[i]) || tag_data[i] == '>')
-		return closed ? HTML_TAG_CLOSE : HTML_TAG_OPEN;
+	if (tpl)
+		return template_link_size(tpl, action, link, link_len);
+
+	while ((link = memchr(link, '"', end - link)) != NULL) {
+		size += sizeof("&quot;") - 2;
+		link++;
+	}
 
-	return HTML_TAG_NONE;
+	if (rule && rule->action == RINKU_POLICY_ATTRS)
+		size += rule->attr_len + 3;
+	else
+		size += cfg->link_close.size;
+
+	return size + sizeof("</a>") - 1;
 }
 
+/*
+ * Cheap first pass over the text: finds every link without rendering
+ * anything, and returns the exact size of the output (or 0 if there are
+ * no links). Link texts from a callback are counted with their original
+ * length.
+ */
 static size_t
-autolink__skip_tag(
+autolink_measure(
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	const struct rinku_compiled *cfg,
+	unsigned int run_flags,
+	uint64_t deadline)
+{
+	struct autolink_scanner sc;
+	struct autolink_pos link;
+	autolink_action action;
+	size_t out_size = 0, last = 0, link_count = 0;
+
+	autolink_scanner_init(&sc, text, size, opts, cfg, run_flags, deadline);
+	sc.stats = NULL;	/* the rendering pass counts everything */
+
+	while ((action = autolink_next(&sc, &link)) != AUTOLINK_ACTION_NONE) {
+		out_size += link.start - last;
+		out_size += autolink_link_size(action,
+			text + link.start, link.end - link.start, opts, cfg, sc.rule);
+		last = link.end;
+		link_count++;
+	}
+
+	if (link_count == 0 || sc.interrupted)
+		return 0;
+
+	return out_size + (sc.stop - last);
+}
+
+static int
+autolink_render(
 	struct buf *ob,
 	const uint8_t *text,
 	size_t size,
-	const char **skip_tags)
+	const struct rinku_options *opts,
+	const struct rinku_compiled *cfg,
+	unsigned int run_flags,
+	size_t *consumed)
 {
+	struct autolink_scanner sc;
+	struct autolink_pos link;
+	autolink_action action;
+	const struct rinku_template *tpl;
+	const size_t ob_size = ob->size;
+	const uint64_t deadline = autolink_deadline(opts);
+	size_t ob_asize = ob->asize;
 	size_t i = 0;
+	int link_count = 0;
+
+	if (opts->flags & AUTOLINK_EXACT_SIZE) {
+		size_t out_size = autolink_measure(text, size,
+			opts, cfg, run_flags, deadline);
+
+		if (out_size > 0)
+			bufgrow(ob, ob->size + out_size);
+	}
+
+	autolink_scanner_init(&sc, text, size, opts, cfg, run_flags, deadline);
+
+	while ((action = autolink_next(&sc, &link)) != AUTOLINK_ACTION_NONE) {
+		const uint8_t *link_str = text + link.start;
+		const size_t link_len = link.end - link.start;
 
-	while (i < size && text[i] != '>')
-		i++;
+		/* Nothing is allocated until the first link shows up; from
+		 * then on the output is at least as long as the input */
+		if (link_count == 0)
+			bufgrow(ob, ob->size + (size - i) +
+				autolink_link_size(action, link_str, link_len,
+					opts, cfg, sc.rule));
 
-	while (*skip_tags != NULL) {
-		if (html_is_tag(text, size, *skip_tags) == HTML_TAG_OPEN)
+		bufput(ob, text + i, link.start - i);
+
+		if ((tpl = link_template(opts, action)) != NULL) {
+			template_render(ob, tpl, action, link_str, link_len, opts);
+		} else {
+			bufput(ob, g_hrefs[action], g_href_lens[action]);
+			print_link(ob, link_str, link_len);
+			link_close(ob, opts, cfg, sc.rule);
+
+			if (opts->link_text_cb) {
+				opts->link_text_cb(ob, link_str, link_len, opts->payload);
+			} else {
+				bufput(ob, link_str, link_len);
+			}
+
+			BUFPUTSL(ob, "</a>");
+		}
+
+		if (sc.stats && ob->asize != ob_asize) {
+			sc.stats->reallocs++;
+			ob_asize = ob->asize;
+		}
+
+		link_count++;
+		i = link.end;
+	}
+
+	if (!sc.interrupted) {
+		if (link_count > 0 || (run_flags & AUTOLINK_RUN_COPY_ALL))
+			bufput(ob, text + i, sc.stop - i);
+
+		*consumed = sc.stop;
+	}
+
+	if (opts->truncated)
+		*opts->truncated = sc.truncated;
+
+	if (sc.stats) {
+		sc.stats->calls++;
+		sc.stats->bytes_scanned +=
+			(sc.interrupted || sc.truncated) ? sc.pos : sc.stop;
+		sc.stats->output_bytes += ob->size - ob_size;
+		if (ob->asize != ob_asize)
+			sc.stats->reallocs++;
+		if (sc.truncated)
+			sc.stats->truncated++;
+	}
+
+	return link_count;
+}
+
+/*
+ * Escapes `text` the way ERB::Util.html_escape does, into `ob`. Returns
+ * false without writing anything if there is nothing to escape.
+ */
+static bool
+escape_html(struct buf *ob, const uint8_t *text, size_t size)
+{
+	size_t i = 0, next = scan_find(&g_escaped, text, 0, size);
+
+	if (next == size)
+		return false;
+
+	/* the common case has a handful of escapes */
+	bufgrow(ob, size + size / 8);
+
+	while (next < size) {
+		bufput(ob, text + i, next - i);
+
+		switch (text[next]) {
+		case '&': BUFPUTSL(ob, "&amp;"); break;
+		case '<': BUFPUTSL(ob, "&lt;"); break;
+		case '>': BUFPUTSL(ob, "&gt;"); break;
+		case '"': BUFPUTSL(ob, "&quot;"); break;
+		default: BUFPUTSL(ob, "&#39;"); break;
+		}
+
+		i = next + 1;
+		next = scan_find(&g_escaped, text, i, size);
+	}
+
+	bufput(ob, text + i, size - i);
+	return true;
+}
+
+/*
+ * Links `text` with the compiled options `cfg`. With AUTOLINK_ESCAPE_HTML,
+ * the escaped text is written to `scratch` first, which is left for the
+ * caller to reuse or release.
+ */
+static int
+autolink_run(
+	struct buf *ob,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	const struct rinku_compiled *cfg,
+	struct buf *scratch,
+	unsigned int run_flags,
+	size_t *consumed)
+{
+	const size_t text_size = size;
+	bool escaped = false;
+	int link_count;
+
+	*consumed = size;
+
+	if (!text || size == 0)
+		return 0;
+
+	scratch->size = 0;
+
+	if ((opts->flags & AUTOLINK_ESCAPE_HTML) && escape_html(scratch, text, size)) {
+		text = scratch->data;
+		size = scratch->size;
+		run_flags |= AUTOLINK_RUN_COPY_ALL;
+		escaped = true;
+	}
+
+	link_count = autolink_render(ob, text, size, opts, cfg, run_flags, consumed);
+
+	/* Escaped text has no markup for the scan to stop at, so it is
+	 * always consumed whole */
+	if (escaped && *consumed == size)
+		*consumed = text_size;
+
+	return link_count;
+}
+
+int
+rinku_autolink_opts(
+	struct buf *ob,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts)
+{
+	struct buf scratch = { NULL, 0, 0, 1024, NULL, NULL };
+	struct rinku_compiled local;
+	const struct rinku_compiled *cfg = opts->compiled;
+	size_t consumed;
+	int link_count;
+
+	if (!text || size == 0)
+		return 0;
+
+	if (!cfg) {
+		if (rinku_compile(&local, opts) < 0)
+			return 0;
+		cfg = &local;
+	}
+
+	link_count = autolink_run(ob, text, size, opts, cfg, &scratch, 0, &consumed);
+
+	if (cfg == &local)
+		rinku_compiled_free(&local);
+
+	bufreset(&scratch);
+	return link_count;
+}
+
+int
+rinku_autolink_scratch(
+	struct buf *ob,
+	struct buf *scratch,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts)
+{
+	size_t consumed;
+
+	return autolink_run(ob, text, size,
+		opts, opts->compiled, scratch, 0, &consumed);
+}
+
+/* Releases the memory of `buf` if it has grown past `trim_size` */
+static void
+ctx_trim(struct buf *buf, size_t trim_size)
+{
+	if (buf->asize > trim_size)
+		bufreset(buf);
+
+	buf->size = 0;
+}
+
+void
+rinku_ctx_init(struct rinku_ctx *ctx, size_t trim_size)
+{
+	memset(ctx, 0x0, sizeof(*ctx));
+	ctx->output.unit = 1024;
+	ctx->scratch.unit = 1024;
+	ctx->compiled.link_close.unit = 16;
+	ctx->trim_size = trim_size ? trim_size : RINKU_CTX_TRIM_SIZE;
+}
+
+int
+rinku_ctx_autolink(
+	struct rinku_ctx *ctx,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts)
+{
+	const struct rinku_compiled *cfg = opts->compiled;
+	size_t consumed;
+
+	/* Whatever a big document left behind is only kept until now */
+	ctx_trim(&ctx->output, ctx->trim_size);
+	ctx_trim(&ctx->scratch, ctx->trim_size);
+
+	if (!cfg) {
+		if (autolink_compile(&ctx->compiled, opts) < 0)
+			return 0;
+		cfg = &ctx->compiled;
+	}
+
+	return autolink_run(&ctx->output, text, size,
+		opts, cfg, &ctx->scratch, 0, &consumed);
+}
+
+void
+rinku_ctx_free(struct rinku_ctx *ctx)
+{
+	bufreset(&ctx->output);
+	bufreset(&ctx->scratch);
+	rinku_compiled_free(&ctx->compiled);
+}
+
+int
+rinku_extract(
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	int (*link_cb)(size_t start, size_t end, rinku_link_kind kind, void *payload),
+	void *payload)
+{
+	struct autolink_scanner sc;
+	struct autolink_pos link;
+	autolink_action action;
+	struct rinku_compiled local;
+	const struct rinku_compiled *cfg = opts->compiled;
+	int link_count = 0;
+
+	if (!cfg) {
+		if (rinku_compile(&local, opts) < 0)
+			return 0;
+		cfg = &local;
+	}
+
+	autolink_scanner_init(&sc, text, size, opts, cfg, 0,
+		autolink_deadline(opts));
+
+	while ((action = autolink_next(&sc, &link)) != AUTOLINK_ACTION_NONE) {
+		link_count++;
+
+		if (link_cb(link.start, link.end, (rinku_link_kind)action, payload))
 			break;
+	}
+
+	if (opts->truncated)
+		*opts->truncated = sc.truncated;
+
+	if (cfg == &local)
+		rinku_compiled_free(&local);
+
+	return link_count;
+}
+
+/* Whether a text may be cut right after `c`: no link or look-behind
+ * crosses an ASCII space */
+static inline bool
+autolink_cut_after(uint8_t c)
+{
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f';
+}
+
+size_t
+rinku_split(
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	size_t piece_size,
+	size_t *cuts,
+	size_t max_cuts)
+{
+	struct rinku_compiled local;
+	const struct rinku_compiled *cfg = opts->compiled;
+	const bool markup = !(opts->flags & AUTOLINK_ESCAPE_HTML);
+	size_t pos = 0, target = piece_size, count = 0;
 
-		skip_tags++;
+	if (piece_size == 0 || max_cuts == 0 || size <= piece_size)
+		return 0;
+
+	if (!cfg) {
+		if (rinku_compile(&local, opts) < 0)
+			return 0;
+		cfg = &local;
 	}
 
-	if (*skip_tags != NULL) {
-		for (;;) {
-			while (i < size && text[i] != '<')
-				i++;
+	while (count < max_cuts && target < size) {
+		const uint8_t *tag = markup ? memchr(text + pos, '<', size - pos) : NULL;
+		const size_t run_end = tag ? (size_t)(tag - text) : size;
+		struct html_tokenizer tok;
 
-			if (i == size)
-				break;
+		/* the first space from the target on, in the text before
+		 * the next tag */
+		if (target < run_end) {
+			size_t i = target > pos ? target : pos;
 
-			if (html_is_tag(text + i, size - i, *skip_tags) == HTML_TAG_CLOSE)
-				break;
+			while (i < run_end && !autolink_cut_after(text[i]))
+				i++;
+
+			if (i < run_end) {
+				pos = target = i + 1;
+				if (pos == size)
+					break;
 
-			i++;
+				cuts[count++] = pos;
+				target += piece_size;
+				continue;
+			}
 		}
 
-		while (i < size && text[i] != '>')
-			i++;
+		if (!tag)
+			break;
+
+		/* step over the tag, or the whole element if it is skipped,
+		 * the same way the scan does */
+		html_tokenizer_init(&tok, &cfg->skip_set);
+		pos = run_end + html_skip(&tok, text + run_end, size - run_end);
+		if (pos == run_end)
+			pos++;
 	}
 
-	return i;
+	if (cfg == &local)
+		rinku_compiled_free(&local);
+
+	return count;
 }
 
 int
@@ -168,86 +1056,177 @@ rinku_autolink(
 	void (*link_text_cb)(struct buf *, const uint8_t *, size_t, void *),
 	void *payload)
 {
-	size_t i, end;
-	char active_chars[256] = {0};
-	int link_count = 0;
+	struct rinku_options opts;
 
-	if (!text || size == 0)
-		return 0;
+	memset(&opts, 0x0, sizeof(opts));
+	opts.mode = mode;
+	opts.flags = flags;
+	opts.link_attr = link_attr;
+	opts.skip_tags = skip_tags;
+	opts.link_text_cb = link_text_cb;
+	opts.payload = payload;
+
+	return rinku_autolink_opts(ob, text, size, &opts);
+}
+
+struct rinku_stream {
+	struct rinku_options opts;
+	struct buf pending;
+	size_t max_pending;
+	struct rinku_compiled compiled;	/* unless `opts` came compiled */
+	struct html_tokenizer tok;
+	bool in_markup;		/* passing through a tag or skipped element */
+	size_t scanned;		/* pending bytes known to have no space */
+	struct buf scratch;	/* escaped text, with AUTOLINK_ESCAPE_HTML */
+};
+
+struct rinku_stream *
+rinku_stream_new(const struct rinku_options *opts, size_t max_pending)
+{
+	struct rinku_stream *stream;
+
+	stream = calloc(1, sizeof(struct rinku_stream));
+	if (!stream)
+		return NULL;
 
-	active_chars['<'] = AUTOLINK_ACTION_SKIP_TAG;
+	stream->opts = *opts;
+	stream->opts.interrupt = NULL;
+	stream->opts.max_bytes = stream->opts.max_links = 0;
+	stream->opts.max_ns = 0;
+	stream->opts.truncated = NULL;
+	stream->pending.unit = 1024;
+	stream->scratch.unit = 1024;
+	stream->max_pending = max_pending ? max_pending : RINKU_STREAM_MAX_PENDING;
 
-	if (mode & AUTOLINK_EMAILS)
-		active_chars['@'] = AUTOLINK_ACTION_EMAIL;
+	if (!stream->opts.compiled) {
+		if (rinku_compile(&stream->compiled, opts) < 0) {
+			rinku_compiled_free(&stream->compiled);
+			free(stream);
+			return NULL;
+		}
 
-	if (mode & AUTOLINK_URLS) {
-		active_chars['w'] = AUTOLINK_ACTION_WWW;
-		active_chars['W'] = AUTOLINK_ACTION_WWW;
-		active_chars[':'] = AUTOLINK_ACTION_URL;
+		stream->opts.compiled = &stream->compiled;
 	}
 
-	if (link_attr != NULL) {
-		while (rinku_isspace(*link_attr))
-			link_attr++;
+	html_tokenizer_init(&stream->tok, &stream->opts.compiled->skip_set);
+
+	return stream;
+}
+
+void
+rinku_stream_free(struct rinku_stream *stream)
+{
+	if (!stream)
+		return;
+
+	rinku_compiled_free(&stream->compiled);
+	free(stream->pending.data);
+	free(stream->scratch.data);
+	free(stream);
+}
+
+/*
+ * Finds how much of the pending text can be linked without seeing what
+ * comes next: everything up to the last ASCII space, because no link or
+ * look-behind can cross one. If there is none and the pending text has
+ * grown too large, cut at the last full UTF-8 character instead.
+ *
+ * Only the bytes fed since the last call are looked at, so a long text
+ * without spaces arriving in small chunks is not searched once per chunk.
+ */
+static size_t
+stream_cut(struct rinku_stream *stream, const uint8_t *text, size_t size)
+{
+	size_t cut = size;
+
+	while (cut > stream->scanned) {
+		if (autolink_cut_after(text[cut - 1]))
+			return cut;
+
+		cut--;
 	}
 
-	bufgrow(ob, size);
+	stream->scanned = size;
 
-	i = end = 0;
+	if (size < stream->max_pending)
+		return 0;
 
-	while (i < size) {
-		struct autolink_pos link;
-		bool link_found;
-		char action = 0;
+	cut = size;
+	while (cut > 0 && (text[cut - 1] & 0xC0) == 0x80)
+		cut--;
 
-		while (end < size && (action = active_chars[text[end]]) == 0)
-			end++;
+	if (cut > 0 && (text[cut - 1] & 0x80) != 0)
+		cut--;
 
-		if (end == size) {
-			if (link_count > 0)
-				bufput(ob, text + i, end - i);
-			break;
-		}
+	return cut ? cut : size;
+}
 
-		if (action == AUTOLINK_ACTION_SKIP_TAG) {
-			end += autolink__skip_tag(ob,
-				text + end, size - end, skip_tags);
-			continue;
-		}
+static int
+stream_flush(struct rinku_stream *stream, struct buf *ob, bool final)
+{
+	int link_count = 0;
 
-		link_found = g_callbacks[(int)action](
-			&link, text, end, size, flags);
+	while (stream->pending.size > 0) {
+		const uint8_t *text = stream->pending.data;
+		size_t size = stream->pending.size;
+		size_t cut, consumed;
 
-		if (link_found && link.start >= i) {
-			const uint8_t *link_str = text + link.start;
-			const size_t link_len = link.end - link.start;
+		if (stream->in_markup) {
+			consumed = html_skip(&stream->tok, text, size);
+			bufput(ob, text, consumed);
+			bufslurp(&stream->pending, consumed);
+			stream->scanned = 0;
 
-			bufput(ob, text + i, link.start - i);
-			bufputs(ob, g_hrefs[(int)action]);
-			print_link(ob, link_str, link_len);
+			if (!html_tokenizer_done(&stream->tok))
+				break;
 
-			if (link_attr) {
-				BUFPUTSL(ob, "\" ");
-				bufputs(ob, link_attr);
-				bufputc(ob, '>');
-			} else {
-				BUFPUTSL(ob, "\">");
-			}
+			stream->in_markup = false;
+			continue;
+		}
 
-			if (link_text_cb) {
-				link_text_cb(ob, link_str, link_len, payload);
-			} else {
-				bufput(ob, link_str, link_len);
-			}
+		cut = final ? size : stream_cut(stream, text, size);
+		if (cut == 0)
+			break;
 
-			BUFPUTSL(ob, "</a>");
+		link_count += autolink_run(ob, text, cut, &stream->opts,
+			stream->opts.compiled, &stream->scratch,
+			AUTOLINK_RUN_COPY_ALL | (final ? 0 : AUTOLINK_RUN_PARTIAL),
+			&consumed);
 
-			link_count++;
-			end = i = link.end;
-		} else {
-			end = end + 1;
+		bufslurp(&stream->pending, consumed);
+		stream->scanned = 0;
+
+		if (consumed == cut) {
+			/* what's left has no spaces, or we'd have cut later */
+			stream->scanned = size - cut;
+			break;
 		}
+
+		/* The scan stopped at markup that doesn't end within the
+		 * text seen so far; pass it through as it arrives */
+		stream->in_markup = true;
 	}
 
 	return link_count;
 }
+
+int
+rinku_stream_feed(struct rinku_stream *stream, struct buf *ob,
+	const uint8_t *text, size_t size)
+{
+	bufput(&stream->pending, text, size);
+	return stream_flush(stream, ob, false);
+}
+
+int
+rinku_stream_finish(struct rinku_stream *stream, struct buf *ob)
+{
+	int link_count = stream_flush(stream, ob, true);
+
+	stream->pending.size = 0;
+	stream->in_markup = false;
+	stream->scanned = 0;
+	html_tokenizer_init(&stream->tok, &stream->opts.compiled->skip_set);
+
+	return link_count;
+}
@@ -3,6 +3,10 @@
 
 #include <stdint.h>
 #include "buffer.h"
+#include "html.h"
+#include "scan.h"
+#include "policy.h"
+#include "template.h"
 
 typedef enum {
 	AUTOLINK_URLS = (1 << 0),
@@ -10,6 +14,125 @@ typedef enum {
 	AUTOLINK_ALL = AUTOLINK_URLS|AUTOLINK_EMAILS
 } autolink_mode;
 
+enum {
+	/* measure the output in a first pass, so it is allocated only once */
+	AUTOLINK_EXACT_SIZE = (1 << 8),
+	/* the input is plain text, not HTML: escape it as it is linked, the
+	 * same as escaping it first. The output is then written whenever
+	 * the text needed escaping, even if it has no links. Ignored by
+	 * rinku_extract. */
+	AUTOLINK_ESCAPE_HTML = (1 << 9),
+};
+
+struct rinku_compiled;
+
+/* Indexes into the per-parser counters of struct rinku_stats */
+enum {
+	RINKU_STATS_WWW = 0,
+	RINKU_STATS_EMAIL,
+	RINKU_STATS_URL,
+	RINKU_STATS_PARSERS
+};
+
+/* struct rinku_stats: where the time of one or more calls went */
+struct rinku_stats {
+	size_t calls;
+	size_t bytes_scanned;
+	size_t markup;			/* `<` found while scanning */
+	size_t markup_bytes;		/* bytes in tags, comments and skipped elements */
+	size_t triggers[RINKU_STATS_PARSERS];	/* times each parser ran */
+	size_t links[RINKU_STATS_PARSERS];	/* ...and found a link */
+	uint64_t parse_ns[RINKU_STATS_PARSERS];	/* time spent in each parser */
+	size_t output_bytes;
+	size_t reallocs;		/* times the output buffer had to grow */
+	size_t truncated;		/* calls cut short by a budget */
+
+	/* set by the caller: also fill in `parse_ns`, which costs two
+	 * clock reads per trigger */
+	int timing;
+};
+
+/* rinku_stats_add: adds the counters of `stats` to `total` */
+void
+rinku_stats_add(struct rinku_stats *total, const struct rinku_stats *stats);
+
+struct rinku_options {
+	autolink_mode mode;
+	unsigned int flags;
+	const char *link_attr;
+	const char **skip_tags;
+	void (*link_text_cb)(struct buf *, const uint8_t *, size_t, void *);
+	void *payload;
+
+	/* when not NULL, linking stops as soon as this becomes non-zero */
+	const volatile int *interrupt;
+
+	/* when not NULL, the result of rinku_compile on these same options;
+	 * otherwise they are compiled on every call */
+	const struct rinku_compiled *compiled;
+
+	/* when not NULL, the counters of every call are added here */
+	struct rinku_stats *stats;
+
+	/* Budgets for each call, or 0 for none: once the scan gets past
+	 * `max_bytes` of the text, would emit more than `max_links` links
+	 * or has run for `max_ns`, linking stops and the rest of the text
+	 * is copied as it is. Streams ignore them. */
+	size_t max_bytes;
+	size_t max_links;
+	uint64_t max_ns;
+
+	/* when not NULL, set to whether a budget cut the call short */
+	int *truncated;
+
+	/* when not NULL, the HTML of every link comes from this template
+	 * instead of `link_attr`, or from `email_template` for email
+	 * addresses if that is not NULL either. `{text}` is what
+	 * `link_text_cb` writes when there is one. */
+	const struct rinku_template *url_template;
+	const struct rinku_template *email_template;
+
+	/* when not NULL, the rule for the host of every link decides
+	 * whether it is linked, and may replace `link_attr` for it (but
+	 * not a template) */
+	const struct rinku_policy *domains;
+};
+
+/* struct rinku_compiled: the parts of the options that can be prepared
+ * once and shared by any number of calls (and threads) */
+struct rinku_compiled {
+	const struct scan_set *triggers;
+	int scanner;		/* which specialized scan loop to run */
+	struct html_tagset skip_set;
+	struct buf link_close;	/* `">` or `" link_attr>` */
+};
+
+/* rinku_compile: compiles `opts`, whose strings must outlive the
+ * result; returns 0, or -1 if out of memory */
+int
+rinku_compile(struct rinku_compiled *cfg, const struct rinku_options *opts);
+
+void
+rinku_compiled_free(struct rinku_compiled *cfg);
+
+int
+rinku_autolink_opts(
+	struct buf *ob,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts);
+
+/* rinku_autolink_scratch: same as rinku_autolink_opts for compiled
+ * options, but the text is escaped into `scratch` (with
+ * AUTOLINK_ESCAPE_HTML), which is left for the caller to release */
+int
+rinku_autolink_scratch(
+	struct buf *ob,
+	struct buf *scratch,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts);
+
 int
 rinku_autolink(
 	struct buf *ob,
@@ -21,5 +144,97 @@ rinku_autolink(
 	const char **skip_tags,
 	void (*link_text_cb)(struct buf *, const uint8_t *, size_t, void *),
 	void *payload);
-	
+
+/* Default size past which a rinku_ctx lets go of its buffers */
+#define RINKU_CTX_TRIM_SIZE (64 * 1024)
+
+/* struct rinku_ctx: buffers kept from one call to the next, so that
+ * linking many small texts stops going through the allocator once the
+ * context is warm. A context must only be used by one thread at a time. */
+struct rinku_ctx {
+	struct buf output;	/* output of the last rinku_ctx_autolink */
+	struct buf scratch;	/* escaped text, with AUTOLINK_ESCAPE_HTML */
+	struct rinku_compiled compiled;	/* for options that aren't compiled */
+	size_t trim_size;	/* buffers past this size are not kept */
+};
+
+/* rinku_ctx_init: sets up an empty context; `trim_size` is the largest
+ * buffer it keeps for the next call, or 0 for RINKU_CTX_TRIM_SIZE */
+void
+rinku_ctx_init(struct rinku_ctx *ctx, size_t trim_size);
+
+/* rinku_ctx_autolink: same as rinku_autolink_opts, writing to
+ * `ctx->output`, which is valid until the next call. The output is
+ * left empty when the text is to be used as it is. */
+int
+rinku_ctx_autolink(
+	struct rinku_ctx *ctx,
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts);
+
+/* rinku_ctx_free: releases the memory of the context, which can be
+ * initialized again afterwards */
+void
+rinku_ctx_free(struct rinku_ctx *ctx);
+
+typedef enum {
+	RINKU_LINK_WWW = 1,
+	RINKU_LINK_EMAIL,
+	RINKU_LINK_URL,
+} rinku_link_kind;
+
+/* rinku_extract: finds the links in the text without rendering any
+ * output, and calls `link_cb` with the byte offsets of each one. The
+ * search stops early if `link_cb` returns non-zero. Returns the number
+ * of links reported. `link_attr` and `link_text_cb` are ignored. */
+int
+rinku_extract(
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	int (*link_cb)(size_t start, size_t end, rinku_link_kind kind, void *payload),
+	void *payload);
+
+/* rinku_split: finds up to `max_cuts` places, about `piece_size` bytes
+ * apart, where `text` can be cut so that linking each piece on its own
+ * and joining the results gives the same output as linking it whole:
+ * right after an ASCII space outside of any tag or skipped element.
+ * Writes their offsets to `cuts` in increasing order, and returns how
+ * many there are. A piece without links is output as it was, so the
+ * joined result must use the text of any piece whose output is empty. */
+size_t
+rinku_split(
+	const uint8_t *text,
+	size_t size,
+	const struct rinku_options *opts,
+	size_t piece_size,
+	size_t *cuts,
+	size_t max_cuts);
+
+/* Default amount of text a stream holds back before it is forced to
+ * cut in the middle of a word */
+#define RINKU_STREAM_MAX_PENDING (1024 * 1024)
+
+struct rinku_stream;
+
+/* rinku_stream_new: creates a stream that links text fed in chunks. The
+ * strings referenced by `opts` must outlive the stream. */
+struct rinku_stream *
+rinku_stream_new(const struct rinku_options *opts, size_t max_pending);
+
+/* rinku_stream_feed: links as much of the text seen so far as possible,
+ * holding back only an unfinished tail; returns the links written */
+int
+rinku_stream_feed(struct rinku_stream *stream, struct buf *ob,
+	const uint8_t *text, size_t size);
+
+/* rinku_stream_finish: links whatever text is still held back; the
+ * stream can be reused for a new document afterwards */
+int
+rinku_stream_finish(struct rinku_stream *stream, struct buf *ob);
+
+void
+rinku_stream_free(struct rinku_stream *stream);
+
 #endif
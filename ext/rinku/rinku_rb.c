@@ -19,15 +19,137 @@
 
 #include <ruby.h>
 #include <ruby/encoding.h>
+#include <ruby/thread.h>
+#include <ruby/thread_native.h>
+#include <ruby/st.h>
+
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+#include <ruby/ractor.h>
+#else
+#define RUBY_TYPED_FROZEN_SHAREABLE 0
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 #include "rinku.h"
 #include "autolink.h"
+#include "scan.h"
+
+#define AUTOLINK_BATCH_MAX_THREADS 64
+#define AUTOLINK_NOGVL_THRESHOLD (64 * 1024)
+#define AUTOLINK_PARALLEL_THRESHOLD (256 * 1024)
+#define AUTOLINK_PARALLEL_MIN_PIECE (64 * 1024)
+#define AUTOLINK_PARALLEL_PIECES_PER_THREAD 4
+#define AUTOLINK_CTX_TRIM_SIZE (16 * 1024)
 
 static VALUE rb_mRinku;
+static VALUE rb_cStream;
+static VALUE rb_cLinker;
+
+/*
+ * Settings that every Ractor reads while linking. Only the main Ractor
+ * may change them, but the others can be reading them at the same time,
+ * so they are always loaded and stored whole.
+ */
+#define SETTING_LOAD(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#define SETTING_STORE(var, value) __atomic_store_n(&(var), (value), __ATOMIC_RELAXED)
+
+static size_t g_nogvl_threshold = AUTOLINK_NOGVL_THRESHOLD;
+static size_t g_parallel_threshold = AUTOLINK_PARALLEL_THRESHOLD;
+
+/* Scan statistics: 0 to skip them, 1 for the counters, 2 to also time
+ * the parsers */
+static int g_stats_mode;
+
+/*
+ * Every thread (or fiber) adds up the statistics of its own calls in its
+ * context, so recording them takes no lock. Rinku.stats sums the live
+ * contexts, which are kept in `g_stats_ctxs`, and what the contexts that
+ * are gone left in `g_stats_retired`. Ractors run in parallel, so both
+ * are only touched under `g_stats_lock`. Rinku.reset_stats starts a new
+ * generation instead of clearing the counters of other threads; each
+ * context clears its own when it sees that it is behind.
+ */
+static struct thread_ctx *g_stats_ctxs;
+static struct rinku_stats g_stats_retired;
+static unsigned long g_stats_generation;
+static rb_nativethread_lock_t g_stats_lock;
+
+/*
+ * Flags that only change how the block is called; they are masked
+ * off before the options reach the engine
+ */
+enum {
+	/* call the block only once for every distinct link in a document */
+	AUTOLINK_MEMOIZE = (1 << 16),
+	/* call the block once per document, with all its distinct links */
+	AUTOLINK_BATCH_CALLBACK = (1 << 17),
+};
+
+#define AUTOLINK_BLOCK_FLAGS (AUTOLINK_MEMOIZE | AUTOLINK_BATCH_CALLBACK)
+
+static ID id_call;
+static ID id_safe_concat, id_append;
+static ID id_thread_ctx;
+static ID id_current, id_main;
+
+/* Interned once when the extension loads, since Ractors may parse
+ * keywords in parallel */
+static ID id_limits[3];
+static ID id_linker_keywords[10];
+static ID id_all, id_email_addresses, id_urls;
+
+/*
+ * Rinku.skip_tags: a shareable snapshot that is never modified once
+ * taken, so any Ractor or thread can link with it while another one
+ * sets a new list. nil until a list is set. Ractors may read and set
+ * it in parallel, so it is only swapped under its lock.
+ */
+struct skip_tags {
+	VALUE rb_tags;		/* shareable Array of frozen Strings */
+	const char **tags;
+	size_t count;
+};
+
+static VALUE g_skip_tags = Qnil;
+static rb_nativethread_lock_t g_skip_tags_lock;
+
+/*
+ * What a thread keeps from one call to the next, so that linking without
+ * a block allocates nothing but the resulting String. It lives in the
+ * thread's (or fiber's) locals and goes away with it; buffers larger than
+ * AUTOLINK_CTX_TRIM_SIZE are not kept.
+ */
+struct thread_ctx {
+	struct rinku_ctx engine;
+	const char **tags;	/* the skip_tags of the last call */
+	size_t tags_capa;
+	struct rinku_stats last_stats;	/* of the last call */
+	struct rinku_stats stats;	/* of every call in `stats_generation` */
+	int truncated;		/* whether a budget cut the last call short */
+	unsigned long stats_generation;
+	struct thread_ctx *prev, *next;	/* in g_stats_ctxs */
+};
+
+/* A link seen before in the document, and the text the block gave it */
+struct link_memo {
+	const uint8_t *link;
+	size_t link_len;
+	VALUE rb_link_text;
+};
 
 struct callback_data {
 	VALUE rb_block;
 	rb_encoding *encoding;
+
+	/* with AUTOLINK_MEMOIZE: link_memo -> link_memo; `rb_memo` keeps
+	 * the link texts alive */
+	st_table *memo;
+	VALUE rb_memo;
 };
 
 static rb_encoding *
@@ -48,192 +170,2622 @@ validate_encoding(VALUE rb_str)
 	return encoding;
 }
 
+static int
+link_memo_cmp(st_data_t a, st_data_t b)
+{
+	const struct link_memo *ma = (const struct link_memo *)a;
+	const struct link_memo *mb = (const struct link_memo *)b;
+
+	return ma->link_len != mb->link_len ||
+		memcmp(ma->link, mb->link, ma->link_len) != 0;
+}
+
+static st_index_t
+link_memo_hash(st_data_t a)
+{
+	const struct link_memo *memo = (const struct link_memo *)a;
+	return st_hash(memo->link, memo->link_len, 0);
+}
+
+static const struct st_hash_type link_memo_type = {
+	link_memo_cmp,
+	link_memo_hash,
+};
+
+static struct link_memo *
+link_memo_find(struct callback_data *data, const uint8_t *link, size_t link_len)
+{
+	struct link_memo key;
+	st_data_t found;
+
+	key.link = link;
+	key.link_len = link_len;
+
+	if (!st_lookup(data->memo, (st_data_t)&key, &found))
+		return NULL;
+
+	return (struct link_memo *)found;
+}
+
+static struct link_memo *
+link_memo_add(struct callback_data *data,
+	const uint8_t *link, size_t link_len, VALUE rb_link_text)
+{
+	struct link_memo *memo = ALLOC(struct link_memo);
+
+	memo->link = link;
+	memo->link_len = link_len;
+	memo->rb_link_text = rb_link_text;
+
+	st_insert(data->memo, (st_data_t)memo, (st_data_t)memo);
+	rb_ary_push(data->rb_memo, rb_link_text);
+	return memo;
+}
+
+static int
+link_memo_free_i(st_data_t key, st_data_t value, st_data_t arg)
+{
+	xfree((void *)value);
+	return ST_CONTINUE;
+}
+
+static VALUE
+callback_data_free(VALUE arg)
+{
+	struct callback_data *data = (struct callback_data *)arg;
+
+	if (data->memo) {
+		st_foreach(data->memo, link_memo_free_i, 0);
+		st_free_table(data->memo);
+		data->memo = NULL;
+	}
+
+	return Qnil;
+}
+
+static VALUE
+callback_link_text(struct callback_data *data, VALUE rb_link_text)
+{
+	if (validate_encoding(rb_link_text) != data->encoding)
+		rb_raise(rb_eArgError, "encoding mismatch");
+
+	return rb_link_text;
+}
+
 static void
 autolink_callback(struct buf *link_text,
 		const uint8_t *url, size_t url_len, void *block)
 {
 	struct callback_data *data = block;
+	struct link_memo *memo = NULL;
 	VALUE rb_link, rb_link_text;
 
-	rb_link = rb_enc_str_new((const char *)url, url_len, data->encoding);
-	rb_link_text = rb_funcall(data->rb_block,
-			rb_intern("call"), 1, rb_link);
+	if (data->memo)
+		memo = link_memo_find(data, url, url_len);
 
-	if (validate_encoding(rb_link_text) != data->encoding)
-		rb_raise(rb_eArgError, "encoding mismatch");
+	if (memo) {
+		rb_link_text = memo->rb_link_text;
+	} else {
+		rb_link = rb_enc_str_new((const char *)url, url_len, data->encoding);
+		rb_link_text = callback_link_text(data,
+			rb_funcall(data->rb_block, id_call, 1, rb_link));
+
+		if (data->memo)
+			link_memo_add(data, url, url_len, rb_link_text);
+	}
 
 	bufput(link_text, RSTRING_PTR(rb_link_text), RSTRING_LEN(rb_link_text));
 }
 
-const char **rinku_load_tags(VALUE rb_skip)
+/*
+ * Points `skip_tags` at the names in `rb_skip`; it must have room for
+ * all of them and the NULL that ends the list
+ */
+static void
+rinku_fill_tags(const char **skip_tags, VALUE rb_skip)
+{
+	long i, count = RARRAY_LEN(rb_skip);
+
+	for (i = 0; i < count; ++i) {
+		VALUE tag = rb_ary_entry(rb_skip, i);
+		Check_Type(tag, T_STRING);
+		skip_tags[i] = StringValueCStr(tag);
+	}
+
+	skip_tags[count] = NULL;
+}
+
+/* Lists the names in `rb_skip` into the tag list of `ctx` */
+static const char **
+rinku_load_tags(VALUE rb_skip, struct thread_ctx *ctx)
 {
-	const char **skip_tags;
-	size_t i, count;
+	size_t count;
 
 	Check_Type(rb_skip, T_ARRAY);
 
 	count = RARRAY_LEN(rb_skip);
-	skip_tags = xmalloc(sizeof(void *) * (count + 1));
+	if (ctx->tags_capa < count + 1) {
+		REALLOC_N(ctx->tags, const char *, count + 1);
+		ctx->tags_capa = count + 1;
+	}
 
-	for (i = 0; i < count; ++i) {
+	rinku_fill_tags(ctx->tags, rb_skip);
+	return ctx->tags;
+}
+
+/*
+ * Returns a frozen copy of the given tag list where every tag is a
+ * frozen String, so its contents stay valid while the GVL is released
+ */
+static VALUE
+rinku_pin_tags(VALUE rb_skip)
+{
+	VALUE rb_pinned;
+	long i;
+
+	Check_Type(rb_skip, T_ARRAY);
+	rb_pinned = rb_ary_new_capa(RARRAY_LEN(rb_skip));
+
+	for (i = 0; i < RARRAY_LEN(rb_skip); ++i) {
 		VALUE tag = rb_ary_entry(rb_skip, i);
 		Check_Type(tag, T_STRING);
-		skip_tags[i] = StringValueCStr(tag);
+		rb_ary_push(rb_pinned, rb_str_new_frozen(tag));
 	}
 
-	skip_tags[count] = NULL;
-	return skip_tags;
+	return rb_obj_freeze(rb_pinned);
 }
 
 /*
- * Document-method: auto_link
- *
- * call-seq:
- *  auto_link(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0)
- *  auto_link(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0) { |link_text| ... }
- *
- * Parses a block of text looking for "safe" urls or email addresses,
- * and turns them into HTML links with the given attributes.
- *
- * NOTE: The block of text may or may not be HTML; if the text is HTML,
- * Rinku will skip the relevant tags to prevent double-linking and linking
- * inside `pre` blocks by default.
- *
- * NOTE: If the input text is HTML, it's expected to be already escaped.
- * Rinku will perform no escaping.
- *
- * NOTE: Currently the follow protocols are considered safe and are the
- * only ones that will be autolinked.
- *
- *     http:// https:// ftp:// mailto://
- *
- * Email addresses are also autolinked by default. URLs without a protocol
- * specifier but starting with 'www.' will also be autolinked, defaulting to
- * the 'http://' protocol.
- *
- * -   `text` is a string in plain text or HTML markup. If the string is formatted in
- * HTML, Rinku is smart enough to skip the links that are already enclosed in `<a>`
- * tags.`
- *
- * -   `mode` is a symbol, either `:all`, `:urls` or `:email_addresses`, 
- * which specifies which kind of links will be auto-linked. 
- *
- * -   `link_attr` is a string containing the link attributes for each link that
- * will be generated. These attributes are not sanitized and will be include as-is
- * in each generated link, e.g.
- *
- *      ~~~~~ruby
- *      auto_link('http://www.pokemon.com', :all, 'target="_blank"')
- *      # => '<a href="http://www.pokemon.com" target="_blank">http://www.pokemon.com</a>'
- *      ~~~~~
- *
- *     This string can be autogenerated from a hash using the Rails `tag_options` helper.
- *
- * -   `skip_tags` is a list of strings with the names of HTML tags that will be skipped
- * when autolinking. If `nil`, this defaults to the value of the global `Rinku.skip_tags`,
- * which is initially `["a", "pre", "code", "kbd", "script"]`.
- *
- * -   `flag` is an optional boolean value specifying whether to recognize
- * 'http://foo' as a valid domain, or require at least one '.'. It defaults to false.
- *
- * -   `&block` is an optional block argument. If a block is passed, it will
- * be yielded for each found link in the text, and its return value will be used instead
- * of the name of the link. E.g.
- *
- *     ~~~~~ruby
- *     auto_link('Check it out at http://www.pokemon.com') do |url|
- *       "THE POKEMAN WEBSITEZ"
- *     end
- *     # => 'Check it out at <a href="http://www.pokemon.com">THE POKEMAN WEBSITEZ</a>'
- *     ~~~~~~
+ * Marks pinned arguments so the GC neither frees nor moves them; the
+ * engine holds raw pointers into every one of the tag Strings
  */
+static void
+rinku_mark_pinned(VALUE rb_html, VALUE rb_skip)
+{
+	long i;
+
+	rb_gc_mark(rb_html);
+	rb_gc_mark(rb_skip);
+
+	if (RB_TYPE_P(rb_skip, T_ARRAY)) {
+		for (i = 0; i < RARRAY_LEN(rb_skip); ++i)
+			rb_gc_mark(RARRAY_AREF(rb_skip, i));
+	}
+}
+
+static void
+skip_tags_mark(void *ptr)
+{
+	struct skip_tags *snapshot = ptr;
+	rinku_mark_pinned(Qnil, snapshot->rb_tags);
+}
+
+static void
+skip_tags_free(void *ptr)
+{
+	struct skip_tags *snapshot = ptr;
+
+	xfree(snapshot->tags);
+	xfree(snapshot);
+}
+
+static const rb_data_type_t rb_skip_tags_type = {
+	"Rinku::SkipTags",
+	{ skip_tags_mark, skip_tags_free, NULL, },
+	NULL, NULL, RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+/* Takes a snapshot of the tag list `rb_skip` */
 static VALUE
-rb_rinku_autolink(int argc, VALUE *argv, VALUE self)
+skip_tags_new(VALUE rb_skip)
 {
-	static const char *SKIP_TAGS[] = {"a", "pre", "code", "kbd", "script", NULL};
+	struct skip_tags *snapshot;
+	VALUE rb_snapshot = TypedData_Make_Struct(0,
+		struct skip_tags, &rb_skip_tags_type, snapshot);
 
-	VALUE result, rb_text, rb_mode, rb_html, rb_skip, rb_flags, rb_block;
-	rb_encoding *text_encoding;
-	struct buf *output_buf;
-	int link_mode = AUTOLINK_ALL, count;
-	unsigned int link_flags = 0;
-	const char *link_attr = NULL;
-	const char **skip_tags = NULL;
-	struct callback_data cbdata;
+	snapshot->rb_tags = rinku_pin_tags(rb_skip);
+	snapshot->count = RARRAY_LEN(snapshot->rb_tags);
+
+	/* The list belongs to the snapshot before it's filled in, so it
+	 * is released by the GC if a tag is refused */
+	snapshot->tags = ALLOC_N(const char *, snapshot->count + 1);
+	snapshot->tags[0] = NULL;
+	rinku_fill_tags(snapshot->tags, snapshot->rb_tags);
+
+	/* a hidden object has no #freeze to call */
+	RB_OBJ_FREEZE_RAW(rb_snapshot);
+	return rb_snapshot;
+}
+
+/* The current snapshot of Rinku.skip_tags, or nil */
+static VALUE
+skip_tags_current(void)
+{
+	VALUE rb_snapshot;
+
+	rb_nativethread_lock_lock(&g_skip_tags_lock);
+	rb_snapshot = g_skip_tags;
+	rb_nativethread_lock_unlock(&g_skip_tags_lock);
+
+	return rb_snapshot;
+}
+
+static const struct skip_tags *
+skip_tags_get(VALUE rb_snapshot)
+{
+	return rb_check_typeddata(rb_snapshot, &rb_skip_tags_type);
+}
+
+/*
+ * Copies the tag list of a snapshot into `ctx`. The copy points into
+ * the Strings of `snapshot->rb_tags`.
+ */
+static const char **
+skip_tags_copy(const struct skip_tags *snapshot, struct thread_ctx *ctx)
+{
+	if (ctx->tags_capa < snapshot->count + 1) {
+		REALLOC_N(ctx->tags, const char *, snapshot->count + 1);
+		ctx->tags_capa = snapshot->count + 1;
+	}
+
+	memcpy(ctx->tags, snapshot->tags, sizeof(char *) * (snapshot->count + 1));
+	return ctx->tags;
+}
+
+/* Returns `stats`, ready to be filled in, or NULL if they are off */
+static struct rinku_stats *
+stats_begin(struct rinku_stats *stats)
+{
+	int mode = SETTING_LOAD(g_stats_mode);
+
+	if (!mode)
+		return NULL;
+
+	memset(stats, 0x0, sizeof(*stats));
+	stats->timing = (mode > 1);
+	return stats;
+}
+
+static struct thread_ctx *thread_ctx_get(void);
+
+static void
+stats_record(struct thread_ctx *ctx, const struct rinku_stats *stats)
+{
+	unsigned long generation =
+		__atomic_load_n(&g_stats_generation, __ATOMIC_ACQUIRE);
+
+	if (ctx->stats_generation != generation) {
+		memset(&ctx->stats, 0x0, sizeof(ctx->stats));
+		__atomic_store_n(&ctx->stats_generation, generation, __ATOMIC_RELEASE);
+	}
+
+	ctx->last_stats = *stats;
+	rinku_stats_add(&ctx->stats, stats);
+}
 
-	rb_scan_args(argc, argv, "14&", &rb_text, &rb_mode,
-		&rb_html, &rb_skip, &rb_flags, &rb_block); 
+static const char *SKIP_TAGS[] = {"a", "pre", "code", "kbd", "script", NULL};
 
-	text_encoding = validate_encoding(rb_text);
+/*
+ * Parses the common linking options. Unless `ctx` is given to keep the
+ * tag list in, `rb_skip` is replaced with a snapshot that owns it. With
+ * `pin`, the attribute String is replaced with a frozen copy. Either
+ * way the caller must keep `rb_html` and `rb_skip` alive for as long
+ * as `opts` is used.
+ */
+static void
+autolink_args_load(struct rinku_options *opts,
+	VALUE rb_mode, VALUE *rb_html, VALUE *rb_skip, VALUE rb_flags,
+	int pin, struct thread_ctx *ctx)
+{
+	memset(opts, 0x0, sizeof(*opts));
+	opts->mode = AUTOLINK_ALL;
+	opts->skip_tags = SKIP_TAGS;
 
 	if (!NIL_P(rb_mode)) {
 		ID mode_sym;
 		Check_Type(rb_mode, T_SYMBOL);
 
 		mode_sym = SYM2ID(rb_mode);
-		if (mode_sym == rb_intern("all"))
-			link_mode = AUTOLINK_ALL;
-		else if (mode_sym == rb_intern("email_addresses"))
-			link_mode = AUTOLINK_EMAILS;
-		else if (mode_sym == rb_intern("urls"))
-			link_mode = AUTOLINK_URLS;
+		if (mode_sym == id_all)
+			opts->mode = AUTOLINK_ALL;
+		else if (mode_sym == id_email_addresses)
+			opts->mode = AUTOLINK_EMAILS;
+		else if (mode_sym == id_urls)
+			opts->mode = AUTOLINK_URLS;
 		else
 			rb_raise(rb_eTypeError,
 				"Invalid linking mode "
 				"(possible values are :all, :urls, :email_addresses)");
 	}
 
-	if (!NIL_P(rb_html)) {
-		Check_Type(rb_html, T_STRING);
-		link_attr = RSTRING_PTR(rb_html);
+	if (!NIL_P(*rb_html)) {
+		Check_Type(*rb_html, T_STRING);
+		if (pin)
+			*rb_html = rb_str_new_frozen(*rb_html);
+		opts->link_attr = RSTRING_PTR(*rb_html);
 	}
 
 	if (!NIL_P(rb_flags)) {
 		Check_Type(rb_flags, T_FIXNUM);
-		link_flags = FIX2INT(rb_flags);
+		opts->flags = FIX2INT(rb_flags);
+
+		/* the block would get the links of the unescaped text */
+		if ((opts->flags & AUTOLINK_ESCAPE_HTML) &&
+			(opts->flags & AUTOLINK_BATCH_CALLBACK))
+			rb_raise(rb_eArgError,
+				"AUTOLINK_ESCAPE_HTML cannot be used with AUTOLINK_BATCH_CALLBACK");
 	}
 
-	if (NIL_P(rb_skip))
-		rb_skip = rb_iv_get(self, "@skip_tags");
+	if (NIL_P(*rb_skip)) {
+		VALUE rb_snapshot = skip_tags_current();
 
-	if (NIL_P(rb_skip)) {
-		skip_tags = SKIP_TAGS;
+		if (!NIL_P(rb_snapshot)) {
+			const struct skip_tags *snapshot = skip_tags_get(rb_snapshot);
+
+			*rb_skip = rb_snapshot;
+			opts->skip_tags = ctx ?
+				skip_tags_copy(snapshot, ctx) : snapshot->tags;
+		}
+	} else if (ctx) {
+		opts->skip_tags = rinku_load_tags(*rb_skip, ctx);
 	} else {
-		skip_tags = rinku_load_tags(rb_skip);
+		/* Owned by the GC, so nothing leaks if the call raises
+		 * before it's done */
+		*rb_skip = skip_tags_new(*rb_skip);
+		opts->skip_tags = skip_tags_get(*rb_skip)->tags;
 	}
+}
 
-	output_buf = bufnew(32);
-	cbdata.rb_block = rb_block;
-	cbdata.encoding = text_encoding;
-	count = rinku_autolink(
-		output_buf,
-		(const uint8_t *)RSTRING_PTR(rb_text),
-		(size_t)RSTRING_LEN(rb_text),
-		link_mode,
-		link_flags,
-		link_attr,
-		skip_tags,
-		RTEST(rb_block) ? &autolink_callback : NULL,
-		(void*)&cbdata);
+static size_t
+autolink_limit(VALUE rb_limit, const char *name)
+{
+	if (!RB_INTEGER_TYPE_P(rb_limit) ||
+		RTEST(rb_funcall(rb_limit, '<', 1, INT2FIX(1))))
+		rb_raise(rb_eArgError, "%s must be a positive Integer", name);
 
-	if (count == 0)
-		result = rb_text;
-	else {
-		result = rb_enc_str_new((char *)output_buf->data, output_buf->size,
-			text_encoding);
+	return NUM2SIZET(rb_limit);
+}
+
+/*
+ * Parses the `max_bytes:`, `max_links:` and `timeout:` keywords into
+ * the budgets of `opts`; `rb_kwargs` may be nil
+ */
+static void
+autolink_limits_load(struct rinku_options *opts, VALUE rb_kwargs)
+{
+	VALUE values[3];
+	double timeout;
+
+	if (NIL_P(rb_kwargs))
+		return;
+
+	rb_get_kwargs(rb_kwargs, id_limits, 0, 3, values);
+
+	if (values[0] != Qundef && !NIL_P(values[0]))
+		opts->max_bytes = autolink_limit(values[0], "max_bytes");
+
+	if (values[1] != Qundef && !NIL_P(values[1]))
+		opts->max_links = autolink_limit(values[1], "max_links");
+
+	if (values[2] != Qundef && !NIL_P(values[2])) {
+		timeout = NUM2DBL(values[2]);
+		if (!(timeout > 0.0))
+			rb_raise(rb_eArgError, "timeout must be positive");
+
+		/* at least a nanosecond, so it doesn't turn into "none" */
+		opts->max_ns = timeout < 1e-9 ? 1 : (uint64_t)(timeout * 1e9);
 	}
+}
+
+/* A text of the batch, or a piece of one that is linked on its own */
+struct autolink_doc {
+	VALUE rb_text;		/* keeps `text` from moving during GC */
+	long index;		/* of the text in the batch */
+	const uint8_t *text;
+	size_t size;
+	struct buf output;
+	struct rinku_stats stats;
+	int count;
+	int truncated;
+	int done;
+};
 
-	if (skip_tags != SKIP_TAGS)
-		xfree(skip_tags);
+struct autolink_batch {
+	struct rinku_options opts;
+	struct rinku_compiled compiled;		/* unless `opts` came compiled */
+	VALUE rb_texts;
+	long text_count;
+	struct autolink_doc *docs;
+	size_t doc_count;
+	size_t next_doc;
+	int stats_mode;
+	volatile int interrupted;
 
-	bufrelease(output_buf);
-	return result;
+	/* while queued for the worker pool, under its lock */
+	struct autolink_batch *next_queued;
+	size_t helpers;		/* pool threads working on it */
+};
+
+static void *
+autolink_batch_worker(void *data)
+{
+	struct autolink_batch *batch = data;
+	struct rinku_options opts = batch->opts;
+	size_t i;
+
+	opts.interrupt = &batch->interrupted;
+	opts.flags &= ~AUTOLINK_BLOCK_FLAGS;
+
+	while (!batch->interrupted &&
+		(i = __sync_fetch_and_add(&batch->next_doc, 1)) < batch->doc_count) {
+		struct autolink_doc *doc = &batch->docs[i];
+
+		if (doc->done)
+			continue;
+
+		if (batch->stats_mode) {
+			memset(&doc->stats, 0x0, sizeof(doc->stats));
+			doc->stats.timing = (batch->stats_mode > 1);
+			opts.stats = &doc->stats;
+		}
+
+		opts.truncated = &doc->truncated;
+		doc->output.size = 0;
+		doc->count = rinku_autolink_opts(
+			&doc->output, doc->text, doc->size, &opts);
+
+		if (!batch->interrupted)
+			doc->done = 1;
+	}
+
+	return NULL;
 }
 
-void RUBY_EXPORT Init_rinku()
+static size_t
+autolink_batch_threads(size_t doc_count)
 {
-	rb_mRinku = rb_define_module("Rinku");
-	rb_define_module_function(rb_mRinku, "auto_link", rb_rinku_autolink, -1);
-	rb_define_const(rb_mRinku, "AUTOLINK_SHORT_DOMAINS", INT2FIX(AUTOLINK_SHORT_DOMAINS));
+	size_t threads = 1;
+
+#if defined(HAVE_PTHREAD_H) && defined(_SC_NPROCESSORS_ONLN)
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 1)
+		threads = (size_t)cpus;
+#endif
+
+	if (threads > doc_count)
+		threads = doc_count;
+
+	if (threads > AUTOLINK_BATCH_MAX_THREADS)
+		threads = AUTOLINK_BATCH_MAX_THREADS;
+
+	return threads;
+}
+
+#ifdef HAVE_PTHREAD_H
+/*
+ * Helper threads that work through batches next to the calling threads.
+ * They are started on first use, one per CPU but the caller's, and are
+ * kept for the life of the process, so a batch costs a wake-up rather
+ * than a thread. A forked child has none of them, and starts its own.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t queued;		/* a batch was queued */
+	pthread_cond_t left;		/* a helper left its batch */
+	struct autolink_batch *queue;	/* batches with documents to claim */
+	size_t helpers;
+	int started;
+} g_pool = {
+	PTHREAD_MUTEX_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	PTHREAD_COND_INITIALIZER,
+	NULL, 0, 0,
+};
+
+static int g_pool_atfork;
+
+/* Takes `batch` off the queue, if it is still there */
+static void
+pool_dequeue(struct autolink_batch *batch)
+{
+	struct autolink_batch **link = &g_pool.queue;
+
+	while (*link && *link != batch)
+		link = &(*link)->next_queued;
+
+	if (*link)
+		*link = batch->next_queued;
+}
+
+static void *
+pool_helper(void *unused)
+{
+	sigset_t signals;
+
+	/* signals are for Ruby's own threads */
+	sigfillset(&signals);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	pthread_mutex_lock(&g_pool.lock);
+	for (;;) {
+		struct autolink_batch *batch = g_pool.queue;
+
+		if (!batch) {
+			pthread_cond_wait(&g_pool.queued, &g_pool.lock);
+			continue;
+		}
+
+		batch->helpers++;
+		pthread_mutex_unlock(&g_pool.lock);
+
+		autolink_batch_worker(batch);
+
+		/* every document of the batch has been claimed */
+		pthread_mutex_lock(&g_pool.lock);
+		pool_dequeue(batch);
+		if (--batch->helpers == 0)
+			pthread_cond_broadcast(&g_pool.left);
+	}
+
+	return NULL;
+}
+
+/* The child of a fork has only the thread that forked */
+static void
+pool_reset_child(void)
+{
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+	g_pool.lock = lock;
+	g_pool.queued = g_pool.left = cond;
+	g_pool.queue = NULL;
+	g_pool.helpers = 0;
+	g_pool.started = 0;
+}
+
+/* Starts the helpers if they aren't yet, with the pool locked; returns
+ * how many there are */
+static size_t
+pool_start(void)
+{
+	size_t t, threads;
+
+	if (g_pool.started)
+		return g_pool.helpers;
+
+	if (!g_pool_atfork) {
+		if (pthread_atfork(NULL, NULL, pool_reset_child) != 0)
+			return 0;
+		g_pool_atfork = 1;
+	}
+
+	g_pool.started = 1;
+	threads = autolink_batch_threads(AUTOLINK_BATCH_MAX_THREADS);
+
+	for (t = 1; t < threads; ++t) {
+		pthread_attr_t attr;
+		pthread_t thread;
+		int created;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		created = pthread_create(&thread, &attr, pool_helper, NULL);
+		pthread_attr_destroy(&attr);
+
+		if (created != 0)
+			break;
+		g_pool.helpers++;
+	}
+
+	return g_pool.helpers;
+}
+#endif
+
+/*
+ * Runs without the GVL: the calling thread works through the batch
+ * together with the pool's helpers, each claiming the next unfinished
+ * document until the batch is done or interrupted
+ */
+static void *
+autolink_batch_run(void *data)
+{
+	struct autolink_batch *batch = data;
+
+#ifdef HAVE_PTHREAD_H
+	size_t wake = 0;
+	int queued = 0;
+
+	batch->next_queued = NULL;
+	batch->helpers = 0;
+
+	if (batch->doc_count > 1) {
+		struct autolink_batch **tail = &g_pool.queue;
+
+		pthread_mutex_lock(&g_pool.lock);
+		wake = pool_start();
+		if (wake > batch->doc_count - 1)
+			wake = batch->doc_count - 1;
+
+		if (wake > 0) {
+			while (*tail)
+				tail = &(*tail)->next_queued;
+			*tail = batch;
+
+			while (wake-- > 0)
+				pthread_cond_signal(&g_pool.queued);
+			queued = 1;
+		}
+		pthread_mutex_unlock(&g_pool.lock);
+	}
+
+	autolink_batch_worker(batch);
+
+	/* the helpers still working on it point into the batch */
+	if (queued) {
+		pthread_mutex_lock(&g_pool.lock);
+		pool_dequeue(batch);
+		while (batch->helpers > 0)
+			pthread_cond_wait(&g_pool.left, &g_pool.lock);
+		pthread_mutex_unlock(&g_pool.lock);
+	}
+#else
+	autolink_batch_worker(batch);
+#endif
+
+	return NULL;
+}
+
+static void
+autolink_batch_interrupt(void *data)
+{
+	struct autolink_batch *batch = data;
+	batch->interrupted = 1;
+}
+
+/*
+ * The result for the text linked as `docs[first, last)`. A piece without
+ * links has no output, and stands for itself in the joined result;
+ * the text is returned as it was if none of them had any links.
+ */
+static VALUE
+autolink_batch_join(struct autolink_batch *batch, size_t first, size_t last,
+	VALUE rb_text, struct rinku_stats *stats)
+{
+	VALUE rb_result;
+	char *out;
+	size_t i, size = 0, copied = 0;
+
+	for (i = first; i < last; ++i) {
+		const struct autolink_doc *doc = &batch->docs[i];
+
+		if (doc->output.size > 0)
+			size += doc->output.size;
+		else
+			copied += doc->size;
+	}
+
+	if (size == 0)
+		return rb_text;
+
+	if (first + 1 == last)
+		return rb_enc_str_new((char *)batch->docs[first].output.data,
+			size, rb_enc_get(rb_text));
+
+	rb_result = rb_enc_str_new(NULL, size + copied, rb_enc_get(rb_text));
+	out = RSTRING_PTR(rb_result);
+
+	for (i = first; i < last; ++i) {
+		const struct autolink_doc *doc = &batch->docs[i];
+
+		if (doc->output.size > 0) {
+			memcpy(out, doc->output.data, doc->output.size);
+			out += doc->output.size;
+		} else {
+			memcpy(out, doc->text, doc->size);
+			out += doc->size;
+		}
+	}
+
+	stats->output_bytes += copied;
+	return rb_result;
+}
+
+static VALUE
+autolink_batch_body(VALUE data)
+{
+	struct autolink_batch *batch = (struct autolink_batch *)data;
+	VALUE rb_result = rb_ary_new_capa(batch->text_count);
+	struct rinku_stats stats;
+	struct thread_ctx *ctx;
+	size_t i, last;
+	int truncated = 0;
+
+	memset(&stats, 0x0, sizeof(stats));
+
+	/* Compile the options once for all the documents */
+	if (!batch->opts.compiled) {
+		if (rinku_compile(&batch->compiled, &batch->opts) < 0)
+			rb_memerror();
+		batch->opts.compiled = &batch->compiled;
+	}
+
+	for (;;) {
+		batch->interrupted = 0;
+		batch->next_doc = 0;
+		rb_thread_call_without_gvl(autolink_batch_run, batch,
+			autolink_batch_interrupt, batch);
+
+		if (!batch->interrupted)
+			break;
+
+		/* Raises if this thread was interrupted by an exception;
+		 * otherwise we go back and finish the remaining documents */
+		rb_thread_check_ints();
+	}
+
+	for (i = 0; i < batch->doc_count; i = last) {
+		VALUE rb_text = rb_ary_entry(batch->rb_texts, batch->docs[i].index);
+
+		for (last = i; last < batch->doc_count &&
+			batch->docs[last].index == batch->docs[i].index; ++last) {
+			if (batch->docs[last].truncated)
+				truncated = 1;
+		}
+
+		rb_ary_push(rb_result,
+			autolink_batch_join(batch, i, last, rb_text, &stats));
+	}
+
+	ctx = thread_ctx_get();
+	ctx->truncated = truncated;
+
+	if (batch->stats_mode) {
+		for (i = 0; i < batch->doc_count; ++i)
+			rinku_stats_add(&stats, &batch->docs[i].stats);
+
+		/* the pieces of a text were all one call */
+		stats.calls -= batch->doc_count - batch->text_count;
+		stats_record(ctx, &stats);
+	}
+
+	return rb_result;
+}
+
+static VALUE
+autolink_batch_free(VALUE data)
+{
+	struct autolink_batch *batch = (struct autolink_batch *)data;
+	size_t i;
+
+	for (i = 0; i < batch->doc_count; ++i)
+		free(batch->docs[i].output.data);
+
+	if (batch->opts.compiled == &batch->compiled)
+		rinku_compiled_free(&batch->compiled);
+
+	return Qnil;
+}
+
+/* Whether `rb_text` is large enough to be split between threads */
+static int
+autolink_parallel(VALUE rb_text, size_t threshold)
+{
+	return threshold > 0 && (size_t)RSTRING_LEN(rb_text) >= threshold;
+}
+
+/*
+ * Links all the Strings in `rb_texts` without holding the GVL and
+ * returns an Array with the results. `opts` must have been loaded with
+ * pinned arguments.
+ */
+static VALUE
+autolink_batch(VALUE rb_texts, struct rinku_options *opts)
+{
+	VALUE rb_pinned, rb_result, tmp;
+	struct autolink_batch batch;
+	long i, count = RARRAY_LEN(rb_texts);
+	size_t capa = (size_t)count, pieces = 1;
+	size_t threshold = SETTING_LOAD(g_parallel_threshold);
+
+	/* Frozen copies keep the input bytes immutable (and alive)
+	 * while the GVL is released */
+	rb_pinned = rb_ary_new_capa(count);
+	for (i = 0; i < count; ++i)
+		rb_ary_push(rb_pinned, rb_str_new_frozen(rb_ary_entry(rb_texts, i)));
+
+	/* Large texts are split to be linked by several threads, unless
+	 * there is only one, or a budget needs to see the whole text in
+	 * order. A few pieces per thread keep them all busy to the end. */
+	if (threshold > 0 &&
+		!opts->max_bytes && !opts->max_links && !opts->max_ns) {
+		size_t threads = autolink_batch_threads(AUTOLINK_BATCH_MAX_THREADS);
+
+		if (threads > 1)
+			pieces = threads * AUTOLINK_PARALLEL_PIECES_PER_THREAD;
+
+		for (i = 0; pieces > 1 && i < count; ++i) {
+			if (autolink_parallel(rb_ary_entry(rb_pinned, i), threshold))
+				capa += pieces - 1;
+		}
+	}
+
+	memset(&batch.compiled, 0x0, sizeof(batch.compiled));
+	batch.opts = *opts;
+	batch.rb_texts = rb_texts;
+	batch.text_count = count;
+	batch.docs = ALLOCV_N(struct autolink_doc, tmp, capa);
+	batch.doc_count = 0;
+	batch.stats_mode = SETTING_LOAD(g_stats_mode);
+
+	for (i = 0; i < count; ++i) {
+		VALUE rb_text = rb_ary_entry(rb_pinned, i);
+		const uint8_t *text = (const uint8_t *)RSTRING_PTR(rb_text);
+		size_t size = (size_t)RSTRING_LEN(rb_text), start = 0, n = 0, c;
+		size_t cuts[AUTOLINK_BATCH_MAX_THREADS * AUTOLINK_PARALLEL_PIECES_PER_THREAD];
+
+		if (pieces > 1 && autolink_parallel(rb_text, threshold)) {
+			size_t piece_size = size / pieces;
+
+			if (piece_size < AUTOLINK_PARALLEL_MIN_PIECE)
+				piece_size = AUTOLINK_PARALLEL_MIN_PIECE;
+
+			n = rinku_split(text, size, opts, piece_size, cuts, pieces - 1);
+		}
+
+		for (c = 0; c <= n; ++c) {
+			struct autolink_doc *doc = &batch.docs[batch.doc_count++];
+			size_t end = (c < n) ? cuts[c] : size;
+
+			memset(doc, 0x0, sizeof(*doc));
+			doc->rb_text = rb_text;
+			doc->index = i;
+			doc->text = text + start;
+			doc->size = end - start;
+			doc->output.unit = 32;
+			start = end;
+		}
+	}
+
+	rb_result = rb_ensure(autolink_batch_body, (VALUE)&batch,
+		autolink_batch_free, (VALUE)&batch);
+
+	ALLOCV_END(tmp);
+	RB_GC_GUARD(rb_pinned);
+	return rb_result;
+}
+
+/*
+ * Custom allocator that lets the engine write straight into a Ruby
+ * String, kept in `buf->opaque`. If there is none yet, it is created
+ * on the first write.
+ */
+static int
+rb_str_buf_grow(struct buf *buf, size_t neoasz)
+{
+	VALUE rb_str = (VALUE)buf->opaque;
+
+	if (!buf->opaque) {
+		rb_str = rb_str_buf_new(neoasz);
+		buf->opaque = (void *)rb_str;
+	} else {
+		rb_str_set_len(rb_str, buf->size);
+		rb_str_modify_expand(rb_str, neoasz - buf->size);
+	}
+
+	buf->data = (uint8_t *)RSTRING_PTR(rb_str);
+	buf->asize = rb_str_capacity(rb_str);
+	return BUF_OK;
+}
+
+struct autolink_call {
+	VALUE rb_text;
+	struct rinku_options opts;
+	struct rinku_compiled compiled;	/* unless `opts` came compiled */
+	struct callback_data cbdata;
+	struct buf output;
+	struct buf scratch;
+	struct rinku_stats *stats;
+	int count;
+	int truncated;
+};
+
+static int
+batch_collect_link(size_t start, size_t end, rinku_link_kind kind, void *payload)
+{
+	struct autolink_call *call = payload;
+	const uint8_t *link = (const uint8_t *)RSTRING_PTR(call->rb_text) + start;
+
+	if (!link_memo_find(&call->cbdata, link, end - start))
+		link_memo_add(&call->cbdata, link, end - start,
+			rb_enc_str_new((const char *)link, end - start,
+				call->cbdata.encoding));
+
+	return 0;
+}
+
+/*
+ * With AUTOLINK_BATCH_CALLBACK: finds all the distinct links first and
+ * calls the block once with all of them. It must return their texts
+ * either as an Array in the same order, or as a Hash keyed by link.
+ */
+static void
+autolink_call_batch(struct autolink_call *call)
+{
+	struct callback_data *data = &call->cbdata;
+	VALUE rb_links, rb_texts;
+	long i, count;
+
+	rinku_extract(
+		(const uint8_t *)RSTRING_PTR(call->rb_text),
+		(size_t)RSTRING_LEN(call->rb_text),
+		&call->opts, &batch_collect_link, call);
+
+	/* For now, every link is memoized as its own text */
+	rb_links = data->rb_memo;
+	count = RARRAY_LEN(rb_links);
+	if (count == 0)
+		return;
+
+	data->rb_memo = rb_ary_new_capa(count);
+	rb_texts = rb_funcall(data->rb_block, id_call, 1, rb_ary_dup(rb_links));
+
+	if (RB_TYPE_P(rb_texts, T_ARRAY)) {
+		if (RARRAY_LEN(rb_texts) != count)
+			rb_raise(rb_eArgError,
+				"expected %ld link texts from the block, got %ld",
+				count, RARRAY_LEN(rb_texts));
+	} else if (!RB_TYPE_P(rb_texts, T_HASH)) {
+		rb_raise(rb_eTypeError,
+			"the block must return an Array or a Hash of link texts");
+	}
+
+	for (i = 0; i < count; ++i) {
+		VALUE rb_link = rb_ary_entry(rb_links, i);
+		VALUE rb_link_text;
+		struct link_memo *memo = link_memo_find(data,
+			(const uint8_t *)RSTRING_PTR(rb_link), RSTRING_LEN(rb_link));
+
+		if (RB_TYPE_P(rb_texts, T_ARRAY))
+			rb_link_text = rb_ary_entry(rb_texts, i);
+		else
+			rb_link_text = rb_hash_lookup2(rb_texts, rb_link, rb_link);
+
+		memo->rb_link_text = callback_link_text(data, rb_link_text);
+		rb_ary_push(data->rb_memo, rb_link_text);
+	}
+
+	RB_GC_GUARD(rb_links);
+	RB_GC_GUARD(rb_texts);
+}
+
+static VALUE
+autolink_call_body(VALUE arg)
+{
+	struct autolink_call *call = (struct autolink_call *)arg;
+
+	if (call->opts.flags & AUTOLINK_BATCH_CALLBACK)
+		autolink_call_batch(call);
+
+	call->opts.flags &= ~AUTOLINK_BLOCK_FLAGS;
+	call->opts.stats = call->stats;
+	call->opts.truncated = &call->truncated;
+	call->count = rinku_autolink_scratch(
+		&call->output, &call->scratch,
+		(const uint8_t *)RSTRING_PTR(call->rb_text),
+		(size_t)RSTRING_LEN(call->rb_text),
+		&call->opts);
+
+	return Qnil;
+}
+
+/* Releases what the engine used for the call, even if the block raised */
+static VALUE
+autolink_call_free(VALUE arg)
+{
+	struct autolink_call *call = (struct autolink_call *)arg;
+
+	callback_data_free((VALUE)&call->cbdata);
+	bufreset(&call->scratch);
+
+	if (call->opts.compiled == &call->compiled)
+		rinku_compiled_free(&call->compiled);
+
+	return Qnil;
+}
+
+/*
+ * Links `rb_text` with the GVL held, appending the output to `*rb_out`.
+ * If `*rb_out` is nil, a new String is only created once a link is
+ * found. Returns the number of links. The output is written through a
+ * raw pointer into `*rb_out`, so it must be nil if the block can reach
+ * it.
+ */
+static int
+autolink_to_str(VALUE *rb_out, VALUE rb_text,
+	const struct rinku_options *args, VALUE rb_block)
+{
+	struct autolink_call call;
+	struct rinku_stats stats;
+	struct thread_ctx *ctx;
+
+	memset(&call, 0x0, sizeof(call));
+	call.rb_text = rb_text;
+	call.opts = *args;
+	call.stats = stats_begin(&stats);
+	call.output.unit = 64;
+	call.output.grow = &rb_str_buf_grow;
+	call.scratch.unit = 1024;
+	call.cbdata.rb_block = rb_block;
+	call.cbdata.encoding = rb_enc_get(rb_text);
+	call.cbdata.rb_memo = Qnil;
+
+	if (RTEST(rb_block)) {
+		/* The engine keeps reading the text while the block runs,
+		 * so it must not change under our feet */
+		call.rb_text = rb_str_new_frozen(rb_text);
+		call.opts.link_text_cb = &autolink_callback;
+		call.opts.payload = &call.cbdata;
+	}
+
+	if (!NIL_P(*rb_out)) {
+		call.output.data = (uint8_t *)RSTRING_PTR(*rb_out);
+		call.output.size = RSTRING_LEN(*rb_out);
+		call.output.asize = rb_str_capacity(*rb_out);
+		call.output.opaque = (void *)*rb_out;
+	}
+
+	if (!call.opts.compiled) {
+		if (rinku_compile(&call.compiled, &call.opts) < 0) {
+			rinku_compiled_free(&call.compiled);
+			rb_memerror();
+		}
+		call.opts.compiled = &call.compiled;
+	}
+
+	if (RTEST(rb_block)) {
+		if (args->flags & AUTOLINK_BLOCK_FLAGS) {
+			call.cbdata.memo = st_init_table(&link_memo_type);
+			call.cbdata.rb_memo = rb_ary_new();
+		}
+
+		rb_ensure(autolink_call_body, (VALUE)&call,
+			autolink_call_free, (VALUE)&call);
+	} else {
+		autolink_call_body((VALUE)&call);
+		autolink_call_free((VALUE)&call);
+	}
+
+	if (call.output.opaque) {
+		*rb_out = (VALUE)call.output.opaque;
+		rb_str_set_len(*rb_out, call.output.size);
+	}
+
+	ctx = thread_ctx_get();
+	ctx->truncated = call.truncated;
+
+	if (call.stats)
+		stats_record(ctx, call.stats);
+
+	RB_GC_GUARD(call.rb_text);
+	RB_GC_GUARD(call.cbdata.rb_memo);
+	return call.count;
+}
+
+static void
+thread_ctx_free(void *ptr)
+{
+	struct thread_ctx *ctx = ptr;
+
+	rb_nativethread_lock_lock(&g_stats_lock);
+	if (ctx->prev)
+		ctx->prev->next = ctx->next;
+	else
+		g_stats_ctxs = ctx->next;
+	if (ctx->next)
+		ctx->next->prev = ctx->prev;
+
+	if (ctx->stats_generation == g_stats_generation)
+		rinku_stats_add(&g_stats_retired, &ctx->stats);
+	rb_nativethread_lock_unlock(&g_stats_lock);
+
+	rinku_ctx_free(&ctx->engine);
+	xfree(ctx->tags);
+	xfree(ctx);
+}
+
+static const rb_data_type_t rb_thread_ctx_type = {
+	"Rinku::ThreadContext",
+	{ NULL, thread_ctx_free, NULL, },
+	NULL, NULL, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+/* This thread's context, created on first use */
+static struct thread_ctx *
+thread_ctx_get(void)
+{
+	VALUE rb_thread = rb_thread_current();
+	VALUE rb_ctx = rb_thread_local_aref(rb_thread, id_thread_ctx);
+	struct thread_ctx *ctx;
+
+	if (!NIL_P(rb_ctx))
+		return rb_check_typeddata(rb_ctx, &rb_thread_ctx_type);
+
+	rb_ctx = TypedData_Make_Struct(rb_cObject,
+		struct thread_ctx, &rb_thread_ctx_type, ctx);
+	rinku_ctx_init(&ctx->engine, AUTOLINK_CTX_TRIM_SIZE);
+	rb_thread_local_aset(rb_thread, id_thread_ctx, rb_ctx);
+
+	rb_nativethread_lock_lock(&g_stats_lock);
+	ctx->stats_generation = g_stats_generation;
+	ctx->next = g_stats_ctxs;
+	if (g_stats_ctxs)
+		g_stats_ctxs->prev = ctx;
+	g_stats_ctxs = ctx;
+	rb_nativethread_lock_unlock(&g_stats_lock);
+
+	return ctx;
+}
+
+/*
+ * Links `rb_text` without a block, through the buffers of `ctx`; only
+ * the result is allocated, at its exact size. No Ruby code may run
+ * between loading the options and this call, or it could reuse `ctx`.
+ */
+static VALUE
+autolink_text_ctx(struct thread_ctx *ctx, VALUE rb_text,
+	const struct rinku_options *args)
+{
+	struct rinku_options opts = *args;
+	struct rinku_stats stats;
+	const struct buf *ob = &ctx->engine.output;
+	int truncated = 0;
+
+	opts.flags &= ~AUTOLINK_BLOCK_FLAGS;
+	opts.stats = stats_begin(&stats);
+	opts.truncated = &truncated;
+
+	rinku_ctx_autolink(&ctx->engine,
+		(const uint8_t *)RSTRING_PTR(rb_text),
+		(size_t)RSTRING_LEN(rb_text), &opts);
+
+	if (opts.stats)
+		stats_record(ctx, opts.stats);
+
+	ctx->truncated = truncated;
+
+	if (ob->size == 0)
+		return rb_text;
+
+	return rb_enc_str_new((const char *)ob->data, ob->size, rb_enc_get(rb_text));
+}
+
+static VALUE
+autolink_text(VALUE rb_text, const struct rinku_options *args, VALUE rb_block)
+{
+	VALUE result = Qnil;
+
+	autolink_to_str(&result, rb_text, args, rb_block);
+	if (NIL_P(result))
+		return rb_text;
+
+	rb_enc_associate(result, rb_enc_get(rb_text));
+	return result;
+}
+
+static int
+autolink_use_nogvl(VALUE rb_text, VALUE rb_block)
+{
+	size_t threshold = SETTING_LOAD(g_nogvl_threshold);
+
+	return NIL_P(rb_block) && threshold > 0 &&
+		(size_t)RSTRING_LEN(rb_text) >= threshold;
+}
+
+/*
+ * Autolinks a single String, loading the options from the arguments
+ * and releasing the GVL if the String is large enough.
+ */
+static VALUE
+autolink_value(VALUE rb_text, VALUE rb_mode,
+	VALUE rb_html, VALUE rb_skip, VALUE rb_flags, VALUE rb_limits,
+	VALUE rb_block)
+{
+	VALUE result;
+	struct rinku_options opts;
+
+	if (autolink_use_nogvl(rb_text, rb_block)) {
+		autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 1, NULL);
+		autolink_limits_load(&opts, rb_limits);
+		result = rb_ary_entry(autolink_batch(rb_ary_new3(1, rb_text), &opts), 0);
+
+		RB_GC_GUARD(rb_html);
+		RB_GC_GUARD(rb_skip);
+		return result;
+	}
+
+	if (NIL_P(rb_block)) {
+		struct thread_ctx *ctx = thread_ctx_get();
+		struct rinku_options limits;
+
+		/* Reading the budgets may call into Ruby, so they go first,
+		 * before the tags are loaded into this thread's context */
+		memset(&limits, 0x0, sizeof(limits));
+		autolink_limits_load(&limits, rb_limits);
+
+		autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 0, ctx);
+		opts.max_bytes = limits.max_bytes;
+		opts.max_links = limits.max_links;
+		opts.max_ns = limits.max_ns;
+
+		result = autolink_text_ctx(ctx, rb_text, &opts);
+
+		RB_GC_GUARD(rb_skip);
+		return result;
+	}
+
+	autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 0, NULL);
+	autolink_limits_load(&opts, rb_limits);
+	result = autolink_text(rb_text, &opts, rb_block);
+
+	RB_GC_GUARD(rb_html);
+	RB_GC_GUARD(rb_skip);
+	return result;
+}
+
+/*
+ * Document-method: auto_link
+ *
+ * call-seq:
+ *  auto_link(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets)
+ *  auto_link(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) { |link_text| ... }
+ *
+ * Parses a block of text looking for "safe" urls or email addresses,
+ * and turns them into HTML links with the given attributes.
+ *
+ * NOTE: The block of text may or may not be HTML; if the text is HTML,
+ * Rinku will skip the relevant tags to prevent double-linking and linking
+ * inside `pre` blocks by default.
+ *
+ * NOTE: If the input text is HTML, it's expected to be already escaped.
+ * Rinku will perform no escaping.
+ *
+ * NOTE: Currently the follow protocols are considered safe and are the
+ * only ones that will be autolinked.
+ *
+ *     http:// https:// ftp:// mailto://
+ *
+ * Email addresses are also autolinked by default. URLs without a protocol
+ * specifier but starting with 'www.' will also be autolinked, defaulting to
+ * the 'http://' protocol.
+ *
+ * -   `text` is a string in plain text or HTML markup. If the string is formatted in
+ * HTML, Rinku is smart enough to skip the links that are already enclosed in `<a>`
+ * tags.`
+ *
+ * -   `mode` is a symbol, either `:all`, `:urls` or `:email_addresses`, 
+ * which specifies which kind of links will be auto-linked. 
+ *
+ * -   `link_attr` is a string containing the link attributes for each link that
+ * will be generated. These attributes are not sanitized and will be include as-is
+ * in each generated link, e.g.
+ *
+ *      ~~~~~ruby
+ *      auto_link('http://www.pokemon.com', :all, 'target="_blank"')
+ *      # => '<a href="http://www.pokemon.com" target="_blank">http://www.pokemon.com</a>'
+ *      ~~~~~
+ *
+ *     This string can be autogenerated from a hash using the Rails `tag_options` helper.
+ *
+ * -   `skip_tags` is a list of strings with the names of HTML tags that will be skipped
+ * when autolinking. If `nil`, this defaults to the value of the global `Rinku.skip_tags`,
+ * which is initially `["a", "pre", "code", "kbd", "script"]`.
+ *
+ * -   `flag` is an optional boolean value specifying whether to recognize
+ * 'http://foo' as a valid domain, or require at least one '.'. It defaults to false.
+ * It can also include `Rinku::AUTOLINK_EXACT_SIZE`, which finds all the links
+ * in a first pass so the output is allocated only once, at its final size, and
+ * `Rinku::AUTOLINK_ESCAPE_HTML`, which treats `text` as plain text rather than
+ * HTML: it is escaped like `ERB::Util.html_escape` as it is linked, in the same
+ * pass, and the result is the same as linking the escaped text.
+ *
+ * -   `&block` is an optional block argument. If a block is passed, it will
+ * be yielded for each found link in the text, and its return value will be used instead
+ * of the name of the link. E.g.
+ *
+ *     ~~~~~ruby
+ *     auto_link('Check it out at http://www.pokemon.com') do |url|
+ *       "THE POKEMAN WEBSITEZ"
+ *     end
+ *     # => 'Check it out at <a href="http://www.pokemon.com">THE POKEMAN WEBSITEZ</a>'
+ *     ~~~~~~
+ *
+ *     With `Rinku::AUTOLINK_MEMOIZE` in `flags`, the block is only called once for
+ * every distinct link in the text, and its result is reused for the repeats. With
+ * `Rinku::AUTOLINK_BATCH_CALLBACK`, the block is called once for the whole text with
+ * an Array of all the distinct links, and must return either an Array with their texts
+ * in the same order, or a Hash from link to text (links missing from the Hash keep
+ * their own text).
+ *
+ * -   `budgets` are the optional `max_bytes:`, `max_links:` and `timeout:`
+ * (in seconds) keywords, which bound the work of the call. Once the scan for links
+ * gets `max_bytes` into the text, finds a link past the first `max_links`, or
+ * takes longer than `timeout`, Rinku stops linking and copies the rest of the text
+ * as it is. `Rinku.truncated?` tells whether that happened. E.g.
+ *
+ *     ~~~~~ruby
+ *     auto_link(comment, max_links: 100, timeout: 0.05)
+ *     ~~~~~
+ *
+ * When no block is given and `text` is larger than `Rinku.nogvl_threshold`,
+ * the GVL is released while linking so other threads can keep running.
+ * Past `Rinku.parallel_threshold`, the text is also cut into pieces at
+ * spaces outside of any markup, which are linked by one thread per CPU;
+ * the result is the same as linking it in one go.
+ */
+static VALUE
+rb_rinku_autolink(int argc, VALUE *argv, VALUE self)
+{
+	VALUE rb_text, rb_mode, rb_html, rb_skip, rb_flags, rb_limits, rb_block;
+
+	rb_scan_args(argc, argv, "14:&", &rb_text, &rb_mode,
+		&rb_html, &rb_skip, &rb_flags, &rb_limits, &rb_block);
+
+	validate_encoding(rb_text);
+	return autolink_value(rb_text, rb_mode,
+		rb_html, rb_skip, rb_flags, rb_limits, rb_block);
+}
+
+/*
+ * Document-method: auto_link!
+ *
+ * call-seq:
+ *  auto_link!(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) -> text or nil
+ *  auto_link!(text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) { |link_text| ... } -> text or nil
+ *
+ * Same as `auto_link`, but replaces the contents of `text` with the
+ * linked HTML. Returns `nil` if no links were found.
+ */
+static VALUE
+rb_rinku_autolink_bang(int argc, VALUE *argv, VALUE self)
+{
+	VALUE rb_text, rb_mode, rb_html, rb_skip, rb_flags, rb_limits, rb_block;
+	VALUE result;
+
+	rb_scan_args(argc, argv, "14:&", &rb_text, &rb_mode,
+		&rb_html, &rb_skip, &rb_flags, &rb_limits, &rb_block);
+
+	validate_encoding(rb_text);
+	rb_str_modify(rb_text);
+
+	result = autolink_value(rb_text, rb_mode,
+		rb_html, rb_skip, rb_flags, rb_limits, rb_block);
+
+	if (result == rb_text)
+		return Qnil;
+
+	rb_str_shared_replace(rb_text, result);
+	return rb_text;
+}
+
+/*
+ * Document-method: auto_link_into
+ *
+ * call-seq:
+ *  auto_link_into(out, text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) -> out
+ *  auto_link_into(out, text, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) { |link_text| ... } -> out
+ *
+ * Same as `auto_link`, but appends the linked HTML to the `out` String
+ * (e.g. a view's output buffer) instead of returning a new String.
+ *
+ * `out` can also be any other object that responds to `safe_concat` or
+ * `<<`, like the `ActionView::OutputBuffer` of Rails 7.1 and later. The
+ * result is then linked into a new String and appended in one call,
+ * with `safe_concat` when `out` has it, so it isn't escaped again.
+ */
+static VALUE
+rb_rinku_autolink_into(int argc, VALUE *argv, VALUE self)
+{
+	VALUE rb_out, rb_text, rb_mode, rb_html, rb_skip, rb_flags, rb_limits, rb_block;
+	rb_encoding *encoding;
+	struct rinku_options opts;
+	long out_len;
+
+	rb_scan_args(argc, argv, "24:&", &rb_out, &rb_text, &rb_mode,
+		&rb_html, &rb_skip, &rb_flags, &rb_limits, &rb_block);
+
+	validate_encoding(rb_text);
+
+	if (!RB_TYPE_P(rb_out, T_STRING)) {
+		ID id_concat = rb_respond_to(rb_out, id_safe_concat) ?
+			id_safe_concat : id_append;
+
+		if (!rb_respond_to(rb_out, id_concat))
+			rb_raise(rb_eTypeError,
+				"wrong argument type %"PRIsVALUE" (expected String or an output buffer)",
+				rb_obj_class(rb_out));
+
+		rb_funcall(rb_out, id_concat, 1, autolink_value(rb_text, rb_mode,
+			rb_html, rb_skip, rb_flags, rb_limits, rb_block));
+		return rb_out;
+	}
+
+	encoding = rb_enc_check(rb_out, rb_text);
+
+	if (rb_out == rb_text)
+		rb_text = rb_str_new_frozen(rb_text);
+
+	rb_str_modify(rb_out);
+
+	if (autolink_use_nogvl(rb_text, rb_block)) {
+		rb_str_buf_append(rb_out, autolink_value(rb_text, rb_mode,
+			rb_html, rb_skip, rb_flags, rb_limits, rb_block));
+		return rb_out;
+	}
+
+	autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 0, NULL);
+	autolink_limits_load(&opts, rb_limits);
+	if (NIL_P(rb_block)) {
+		out_len = RSTRING_LEN(rb_out);
+		autolink_to_str(&rb_out, rb_text, &opts, rb_block);
+		if (RSTRING_LEN(rb_out) == out_len)
+			rb_str_buf_append(rb_out, rb_text);
+	} else {
+		/* The block may change `out`, so it is only appended to
+		 * once the block is done */
+		rb_str_buf_append(rb_out, autolink_text(rb_text, &opts, rb_block));
+	}
+
+	RB_GC_GUARD(rb_html);
+	RB_GC_GUARD(rb_skip);
+
+	rb_enc_associate(rb_out, encoding);
+	return rb_out;
+}
+
+static VALUE g_link_kinds[RINKU_LINK_URL + 1];
+
+struct extract_data {
+	struct rinku_options opts;
+	struct rinku_compiled compiled;
+	VALUE rb_text;
+};
+
+static int
+extract_yield(size_t start, size_t end, rinku_link_kind kind, void *payload)
+{
+	rb_yield_values(3, SIZET2NUM(start), SIZET2NUM(end), g_link_kinds[kind]);
+	return 0;
+}
+
+static VALUE
+extract_each_body(VALUE data)
+{
+	struct extract_data *ex = (struct extract_data *)data;
+
+	rinku_extract(
+		(const uint8_t *)RSTRING_PTR(ex->rb_text),
+		(size_t)RSTRING_LEN(ex->rb_text),
+		&ex->opts, &extract_yield, NULL);
+
+	return Qnil;
+}
+
+/* The block may break out of the scan, or raise */
+static VALUE
+extract_free(VALUE data)
+{
+	struct extract_data *ex = (struct extract_data *)data;
+	rinku_compiled_free(&ex->compiled);
+	return Qnil;
+}
+
+/*
+ * Document-method: each_link
+ *
+ * call-seq:
+ *  each_link(text, mode=:all, skip_tags=nil, flags=0) { |start, end, kind| ... } -> nil
+ *  each_link(text, mode=:all, skip_tags=nil, flags=0) -> enumerator
+ *
+ * Finds the links in `text` without rendering any HTML, and yields the
+ * *byte* offsets where each one starts and ends, together with its
+ * kind (`:url`, `:www` or `:email`). The text of a link can be
+ * retrieved with `text.byteslice(start...end)`.
+ *
+ * `mode`, `skip_tags` and `flags` work the same as in `auto_link`.
+ * Links are found lazily, so breaking out of the block (or stopping an
+ * external enumerator) skips the rest of the text.
+ */
+static VALUE
+rb_rinku_each_link(int argc, VALUE *argv, VALUE self)
+{
+	struct extract_data ex;
+	VALUE rb_text, rb_mode, rb_skip, rb_flags, rb_html = Qnil;
+
+	RETURN_ENUMERATOR(self, argc, argv);
+
+	rb_scan_args(argc, argv, "13", &rb_text, &rb_mode, &rb_skip, &rb_flags);
+
+	validate_encoding(rb_text);
+
+	/* The block may change any of these while we are scanning */
+	ex.rb_text = rb_str_new_frozen(rb_text);
+	autolink_args_load(&ex.opts, rb_mode, &rb_html, &rb_skip, rb_flags, 1, NULL);
+
+	if (rinku_compile(&ex.compiled, &ex.opts) < 0) {
+		rinku_compiled_free(&ex.compiled);
+		rb_memerror();
+	}
+	ex.opts.compiled = &ex.compiled;
+
+	rb_ensure(extract_each_body, (VALUE)&ex, extract_free, (VALUE)&ex);
+
+	RB_GC_GUARD(rb_skip);
+	RB_GC_GUARD(ex.rb_text);
+	return Qnil;
+}
+
+static int
+extract_pack(size_t start, size_t end, rinku_link_kind kind, void *payload)
+{
+	VALUE rb_result = (VALUE)payload;
+	uint32_t fields[3];
+	char packed[sizeof(fields)];
+	size_t i;
+
+	fields[0] = (uint32_t)start;
+	fields[1] = (uint32_t)end;
+	fields[2] = (uint32_t)kind;
+
+	for (i = 0; i < sizeof(packed); ++i)
+		packed[i] = (char)(fields[i / 4] >> (8 * (i % 4)));
+
+	rb_str_cat(rb_result, packed, sizeof(packed));
+	return 0;
+}
+
+/*
+ * Document-method: link_offsets
+ *
+ * call-seq:
+ *  link_offsets(text, mode=:all, skip_tags=nil, flags=0) -> String
+ *
+ * Same as `each_link`, but returns all the links packed in a binary
+ * String with three little-endian 32-bit integers per link: the start
+ * and end byte offsets, and the kind of the link (1 for `www.` links,
+ * 2 for emails and 3 for URLs). This allocates a single object no
+ * matter how many links there are.
+ *
+ *   Rinku.link_offsets(text).unpack("V*").each_slice(3) do |start, stop, kind|
+ *     ...
+ *   end
+ */
+static VALUE
+rb_rinku_link_offsets(int argc, VALUE *argv, VALUE self)
+{
+	struct rinku_options opts;
+	VALUE rb_text, rb_mode, rb_skip, rb_flags, rb_result, rb_html = Qnil;
+
+	rb_scan_args(argc, argv, "13", &rb_text, &rb_mode, &rb_skip, &rb_flags);
+
+	validate_encoding(rb_text);
+	if ((unsigned long)RSTRING_LEN(rb_text) > 0xFFFFFFFFUL)
+		rb_raise(rb_eRangeError, "text is too long for 32-bit offsets");
+
+	autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 0, NULL);
+
+	rb_result = rb_str_buf_new(0);
+	rinku_extract(
+		(const uint8_t *)RSTRING_PTR(rb_text),
+		(size_t)RSTRING_LEN(rb_text),
+		&opts, &extract_pack, (void *)rb_result);
+
+	RB_GC_GUARD(rb_skip);
+	return rb_result;
+}
+
+/*
+ * Document-method: auto_link_many
+ *
+ * call-seq:
+ *  auto_link_many(texts, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets)
+ *  auto_link_many(texts, mode=:all, link_attr=nil, skip_tags=nil, flags=0, **budgets) { |link_text| ... }
+ *
+ * Autolinks every String in the `texts` Array with the same options as
+ * `auto_link`, and returns an Array with the results in the same order.
+ *
+ * All the documents are validated before any work starts. The linking
+ * itself runs without holding the GVL, spread over one native thread per
+ * CPU, so other Ruby threads keep running while a big batch is processed.
+ * The threads are started on the first call and reused by later ones.
+ *
+ * If a block is given, it has to be called with the GVL held, so the
+ * documents are linked one after another on the calling thread.
+ */
+static VALUE
+rb_rinku_autolink_many(int argc, VALUE *argv, VALUE self)
+{
+	VALUE rb_texts, rb_mode, rb_html, rb_skip, rb_flags, rb_limits, rb_block;
+	VALUE rb_result;
+	struct rinku_options opts;
+	long i, count;
+	int truncated = 0;
+
+	rb_scan_args(argc, argv, "14:&", &rb_texts, &rb_mode,
+		&rb_html, &rb_skip, &rb_flags, &rb_limits, &rb_block);
+
+	Check_Type(rb_texts, T_ARRAY);
+	rb_texts = rb_ary_dup(rb_texts);
+	count = RARRAY_LEN(rb_texts);
+
+	for (i = 0; i < count; ++i)
+		validate_encoding(rb_ary_entry(rb_texts, i));
+
+	if (RTEST(rb_block)) {
+		autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 0, NULL);
+		autolink_limits_load(&opts, rb_limits);
+		rb_result = rb_ary_new_capa(count);
+
+		for (i = 0; i < count; ++i) {
+			rb_ary_push(rb_result,
+				autolink_text(rb_ary_entry(rb_texts, i), &opts, rb_block));
+			truncated |= thread_ctx_get()->truncated;
+		}
+
+		thread_ctx_get()->truncated = truncated;
+		RB_GC_GUARD(rb_html);
+		RB_GC_GUARD(rb_skip);
+		return rb_result;
+	}
+
+	autolink_args_load(&opts, rb_mode, &rb_html, &rb_skip, rb_flags, 1, NULL);
+	autolink_limits_load(&opts, rb_limits);
+	rb_result = autolink_batch(rb_texts, &opts);
+
+	RB_GC_GUARD(rb_html);
+	RB_GC_GUARD(rb_skip);
+	return rb_result;
+}
+
+/*
+ * Document-method: skip_tags
+ *
+ * call-seq:
+ *  skip_tags -> Array or nil
+ *
+ * The tags that are skipped when a call doesn't give its own list, as
+ * a frozen Array that can be shared between Ractors; `nil` for the
+ * default of `["a", "pre", "code", "kbd", "script"]`.
+ */
+static VALUE
+rb_rinku_skip_tags(VALUE self)
+{
+	VALUE rb_snapshot = skip_tags_current();
+
+	if (NIL_P(rb_snapshot))
+		return Qnil;
+
+	return skip_tags_get(rb_snapshot)->rb_tags;
+}
+
+/*
+ * Document-method: skip_tags=
+ *
+ * call-seq:
+ *  skip_tags = tags
+ *
+ * Sets the tags that are skipped when a call doesn't give its own list.
+ * A frozen copy of `tags` is taken, so changing the Array afterwards
+ * has no effect; calls that are already running keep the list they
+ * started with.
+ */
+static VALUE
+rb_rinku_set_skip_tags(VALUE self, VALUE rb_skip)
+{
+	VALUE rb_snapshot = NIL_P(rb_skip) ? Qnil : skip_tags_new(rb_skip);
+
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	if (!NIL_P(rb_snapshot))
+		rb_ractor_make_shareable(rb_snapshot);
+#endif
+
+	rb_nativethread_lock_lock(&g_skip_tags_lock);
+	g_skip_tags = rb_snapshot;
+	rb_nativethread_lock_unlock(&g_skip_tags_lock);
+
+	return rb_skip;
+}
+
+/* Raises unless called from the main Ractor, the only one that may
+ * change the settings */
+static void
+setting_check_writable(const char *name)
+{
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	if (rb_funcall(rb_cRactor, id_current, 0) != rb_funcall(rb_cRactor, id_main, 0))
+		rb_raise(rb_const_get(rb_cRactor, rb_intern("IsolationError")),
+			"Rinku.%s can only be set from the main Ractor", name);
+#endif
+}
+
+/*
+ * Document-method: nogvl_threshold
+ *
+ * call-seq:
+ *  nogvl_threshold -> Integer or nil
+ *
+ * Size in bytes above which `auto_link` releases the GVL while linking
+ * a document (when no block is given). `nil` if this is disabled.
+ */
+static VALUE
+rb_rinku_nogvl_threshold(VALUE self)
+{
+	size_t threshold = SETTING_LOAD(g_nogvl_threshold);
+	return threshold ? SIZET2NUM(threshold) : Qnil;
+}
+
+/*
+ * Document-method: nogvl_threshold=
+ *
+ * call-seq:
+ *  nogvl_threshold = bytes
+ *
+ * Sets the size in bytes above which `auto_link` releases the GVL;
+ * `nil` or `0` always keep the GVL. Only the main Ractor can set it.
+ */
+static VALUE
+rb_rinku_set_nogvl_threshold(VALUE self, VALUE rb_threshold)
+{
+	setting_check_writable("nogvl_threshold");
+	SETTING_STORE(g_nogvl_threshold,
+		NIL_P(rb_threshold) ? 0 : NUM2SIZET(rb_threshold));
+	return rb_threshold;
+}
+
+/*
+ * Document-method: parallel_threshold
+ *
+ * call-seq:
+ *  parallel_threshold -> Integer or nil
+ *
+ * Size in bytes above which a document that is linked without the GVL
+ * is split into pieces, which are linked by several threads at once.
+ * `nil` if this is disabled.
+ */
+static VALUE
+rb_rinku_parallel_threshold(VALUE self)
+{
+	size_t threshold = SETTING_LOAD(g_parallel_threshold);
+	return threshold ? SIZET2NUM(threshold) : Qnil;
+}
+
+/*
+ * Document-method: parallel_threshold=
+ *
+ * call-seq:
+ *  parallel_threshold = bytes
+ *
+ * Sets the size in bytes above which a document is linked by several
+ * threads at once; `nil` or `0` always link it with a single thread.
+ * Only the main Ractor can set it.
+ */
+static VALUE
+rb_rinku_set_parallel_threshold(VALUE self, VALUE rb_threshold)
+{
+	setting_check_writable("parallel_threshold");
+	SETTING_STORE(g_parallel_threshold,
+		NIL_P(rb_threshold) ? 0 : NUM2SIZET(rb_threshold));
+	return rb_threshold;
+}
+
+static VALUE
+stats_per_parser(const size_t *counts)
+{
+	VALUE rb_hash = rb_hash_new();
+	int i;
+
+	for (i = 0; i < RINKU_STATS_PARSERS; ++i)
+		rb_hash_aset(rb_hash, g_link_kinds[i + 1], SIZET2NUM(counts[i]));
+
+	return rb_hash;
+}
+
+static VALUE
+stats_to_hash(const struct rinku_stats *stats)
+{
+	VALUE rb_hash = rb_hash_new();
+	VALUE rb_times = rb_hash_new();
+	int i;
+
+#define STATS_SET(name) \
+	rb_hash_aset(rb_hash, ID2SYM(rb_intern(#name)), SIZET2NUM(stats->name))
+
+	STATS_SET(calls);
+	STATS_SET(bytes_scanned);
+	STATS_SET(markup);
+	STATS_SET(markup_bytes);
+	STATS_SET(output_bytes);
+	STATS_SET(reallocs);
+	STATS_SET(truncated);
+
+#undef STATS_SET
+
+	for (i = 0; i < RINKU_STATS_PARSERS; ++i)
+		rb_hash_aset(rb_times, g_link_kinds[i + 1], ULL2NUM(stats->parse_ns[i]));
+
+	rb_hash_aset(rb_hash, ID2SYM(rb_intern("triggers")), stats_per_parser(stats->triggers));
+	rb_hash_aset(rb_hash, ID2SYM(rb_intern("links")), stats_per_parser(stats->links));
+	rb_hash_aset(rb_hash, ID2SYM(rb_intern("parse_ns")), rb_times);
+
+	return rb_hash;
+}
+
+/*
+ * Document-method: collect_stats
+ *
+ * call-seq:
+ *  collect_stats -> false, true or :timing
+ *
+ * Whether linking keeps the counters behind `Rinku.last_stats` and
+ * `Rinku.stats`, and whether it also times the parsers.
+ */
+static VALUE
+rb_rinku_collect_stats(VALUE self)
+{
+	int mode = SETTING_LOAD(g_stats_mode);
+
+	if (mode > 1)
+		return ID2SYM(rb_intern("timing"));
+
+	return mode ? Qtrue : Qfalse;
+}
+
+/*
+ * Document-method: collect_stats=
+ *
+ * call-seq:
+ *  collect_stats = false, true or :timing
+ *
+ * Turns the scan statistics on (`true`) or off (`false`, the default).
+ * With `:timing`, the time spent in each parser is measured as well,
+ * which costs two clock reads for every candidate link. Only the main
+ * Ractor can change this.
+ */
+static VALUE
+rb_rinku_set_collect_stats(VALUE self, VALUE rb_mode)
+{
+	int mode;
+
+	setting_check_writable("collect_stats");
+
+	if (SYMBOL_P(rb_mode) && SYM2ID(rb_mode) == rb_intern("timing"))
+		mode = 2;
+	else if (SYMBOL_P(rb_mode))
+		rb_raise(rb_eArgError, "expected true, false or :timing");
+	else
+		mode = RTEST(rb_mode) ? 1 : 0;
+
+	SETTING_STORE(g_stats_mode, mode);
+
+	return rb_mode;
+}
+
+/*
+ * Document-method: last_stats
+ *
+ * call-seq:
+ *  last_stats -> Hash or nil
+ *
+ * The counters of the last call that linked text on this thread or
+ * fiber (all
+ * the documents of `auto_link_many` count as one call), or `nil` if
+ * there was none since the statistics were turned on:
+ *
+ * -   `:calls`: documents linked
+ * -   `:bytes_scanned`: input bytes scanned
+ * -   `:markup`, `:markup_bytes`: `<` found, and bytes skipped as tags,
+ *     comments or the contents of `skip_tags`
+ * -   `:triggers`: times each parser (`:www`, `:email`, `:url`) ran
+ * -   `:links`: times it found a link
+ * -   `:parse_ns`: nanoseconds spent in each parser, with `:timing`
+ * -   `:output_bytes`: bytes written
+ * -   `:reallocs`: times the output had to grow
+ * -   `:truncated`: documents cut short by a budget
+ */
+static VALUE
+rb_rinku_last_stats(VALUE self)
+{
+	struct thread_ctx *ctx;
+
+	if (!SETTING_LOAD(g_stats_mode))
+		return Qnil;
+
+	ctx = thread_ctx_get();
+	if (ctx->last_stats.calls == 0)
+		return Qnil;
+
+	return stats_to_hash(&ctx->last_stats);
+}
+
+/*
+ * Document-method: stats
+ *
+ * call-seq:
+ *  stats -> Hash
+ *
+ * The same counters as `Rinku.last_stats`, added up for every call in
+ * the process since the statistics were last reset. Each thread keeps
+ * its own counters, which are only summed here; calls running in other
+ * Ractors at the same time may or may not be counted yet.
+ */
+static VALUE
+rb_rinku_stats(VALUE self)
+{
+	struct rinku_stats total;
+	const struct thread_ctx *ctx;
+
+	rb_nativethread_lock_lock(&g_stats_lock);
+	total = g_stats_retired;
+	for (ctx = g_stats_ctxs; ctx; ctx = ctx->next) {
+		if (__atomic_load_n(&ctx->stats_generation, __ATOMIC_ACQUIRE) ==
+			g_stats_generation)
+			rinku_stats_add(&total, &ctx->stats);
+	}
+	rb_nativethread_lock_unlock(&g_stats_lock);
+
+	return stats_to_hash(&total);
+}
+
+/*
+ * Document-method: reset_stats
+ *
+ * call-seq:
+ *  reset_stats -> nil
+ *
+ * Resets the totals behind `Rinku.stats`.
+ */
+static VALUE
+rb_rinku_reset_stats(VALUE self)
+{
+	rb_nativethread_lock_lock(&g_stats_lock);
+	memset(&g_stats_retired, 0x0, sizeof(g_stats_retired));
+	__atomic_store_n(&g_stats_generation,
+		g_stats_generation + 1, __ATOMIC_RELEASE);
+	rb_nativethread_lock_unlock(&g_stats_lock);
+
+	memset(&thread_ctx_get()->last_stats, 0x0, sizeof(struct rinku_stats));
+	return Qnil;
+}
+
+/*
+ * Document-method: truncated?
+ *
+ * call-seq:
+ *  truncated? -> true or false
+ *
+ * Whether the last call that linked text on this thread or fiber ran
+ * out of one of its budgets (`max_bytes:`, `max_links:` or `timeout:`)
+ * and copied the rest of its text without linking it. For
+ * `auto_link_many`, whether any of its documents did.
+ */
+static VALUE
+rb_rinku_truncated_p(VALUE self)
+{
+	return thread_ctx_get()->truncated ? Qtrue : Qfalse;
+}
+
+struct stream_data {
+	struct rinku_stream *stream;
+	struct rinku_options opts;
+	struct callback_data cbdata;
+	VALUE rb_io;
+	VALUE rb_html;
+	VALUE rb_skip;
+	int busy;	/* in the middle of a write, maybe running the block */
+};
+
+static void
+rb_stream_mark(void *ptr)
+{
+	struct stream_data *data = ptr;
+
+	rb_gc_mark(data->rb_io);
+	rb_gc_mark(data->cbdata.rb_block);
+	rinku_mark_pinned(data->rb_html, data->rb_skip);
+}
+
+static void
+rb_stream_free(void *ptr)
+{
+	struct stream_data *data = ptr;
+
+	if (data->stream)
+		rinku_stream_free(data->stream);
+
+	xfree(data);
+}
+
+static const rb_data_type_t rb_stream_type = {
+	"Rinku::Stream",
+	{ rb_stream_mark, rb_stream_free, NULL, },
+	NULL, NULL, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE
+rb_stream_alloc(VALUE klass)
+{
+	struct stream_data *data;
+	VALUE self = TypedData_Make_Struct(klass,
+		struct stream_data, &rb_stream_type, data);
+
+	data->rb_io = data->cbdata.rb_block = Qnil;
+	data->rb_html = data->rb_skip = Qnil;
+	return self;
+}
+
+static struct stream_data *
+rb_stream_get(VALUE self)
+{
+	struct stream_data *data;
+	TypedData_Get_Struct(self, struct stream_data, &rb_stream_type, data);
+
+	if (!data->stream)
+		rb_raise(rb_eArgError, "uninitialized stream");
+
+	/* The engine reads the text it holds back while the block runs,
+	 * so the block can't write to the same stream again */
+	if (data->busy)
+		rb_raise(rb_eRuntimeError, "Rinku::Stream is already writing");
+
+	return data;
+}
+
+/*
+ * Document-method: Rinku::Stream.new
+ *
+ * call-seq:
+ *  Stream.new(io, mode=:all, link_attr=nil, skip_tags=nil, flags=0)
+ *  Stream.new(io, mode=:all, link_attr=nil, skip_tags=nil, flags=0) { |link_text| ... }
+ *
+ * Creates a stream that autolinks the text written to it in chunks, and
+ * writes the resulting HTML to `io` as it goes. The other arguments have
+ * the same meaning as in `Rinku.auto_link`.
+ *
+ * Only the unfinished tail of the text is held back between writes: a
+ * word that may still turn out to be a link, or a tag or skipped element
+ * that has not been closed yet. If the held back text grows over 1MB
+ * without a single space, it is linked as it is.
+ */
+static VALUE
+rb_stream_initialize(int argc, VALUE *argv, VALUE self)
+{
+	VALUE rb_io, rb_mode, rb_html, rb_skip, rb_flags, rb_block;
+	struct stream_data *data;
+
+	TypedData_Get_Struct(self, struct stream_data, &rb_stream_type, data);
+	if (data->stream)
+		rb_raise(rb_eArgError, "stream already initialized");
+
+	rb_scan_args(argc, argv, "14&", &rb_io, &rb_mode,
+		&rb_html, &rb_skip, &rb_flags, &rb_block);
+
+	autolink_args_load(&data->opts, rb_mode,
+		&rb_html, &rb_skip, rb_flags, 1, NULL);
+
+	/* Link texts can't be memoized across chunks */
+	data->opts.flags &= ~AUTOLINK_BLOCK_FLAGS;
+
+	if (RTEST(rb_block)) {
+		data->opts.link_text_cb = &autolink_callback;
+		data->opts.payload = &data->cbdata;
+	}
+
+	data->stream = rinku_stream_new(&data->opts, 0);
+	if (!data->stream)
+		rb_raise(rb_eNoMemError, "failed to allocate stream");
+
+	data->rb_io = rb_io;
+	data->rb_html = rb_html;
+	data->rb_skip = rb_skip;
+	data->cbdata.rb_block = rb_block;
+	data->cbdata.encoding = rb_usascii_encoding();
+	return self;
+}
+
+static VALUE
+stream_write_output(VALUE arg)
+{
+	VALUE *args = (VALUE *)arg;
+	struct stream_data *data = (struct stream_data *)args[0];
+	struct buf *ob = (struct buf *)args[1];
+	VALUE rb_text = args[2];
+
+	if (NIL_P(rb_text))
+		rinku_stream_finish(data->stream, ob);
+	else
+		rinku_stream_feed(data->stream, ob,
+			(const uint8_t *)RSTRING_PTR(rb_text), RSTRING_LEN(rb_text));
+
+	if (ob->size > 0)
+		rb_io_write(data->rb_io, rb_enc_str_new(
+			(char *)ob->data, ob->size, data->cbdata.encoding));
+
+	return Qnil;
+}
+
+static VALUE
+stream_release_output(VALUE arg)
+{
+	VALUE *args = (VALUE *)arg;
+
+	((struct stream_data *)args[0])->busy = 0;
+	bufrelease((struct buf *)args[1]);
+	return Qnil;
+}
+
+static void
+stream_write(struct stream_data *data, VALUE rb_text)
+{
+	VALUE args[3];
+
+	args[0] = (VALUE)data;
+	args[1] = (VALUE)bufnew(1024);
+	args[2] = rb_text;
+
+	data->busy = 1;
+	rb_ensure(stream_write_output, (VALUE)args,
+		stream_release_output, (VALUE)args);
+}
+
+/*
+ * Document-method: Rinku::Stream#write
+ *
+ * call-seq:
+ *  write(text) -> Integer
+ *  stream << text -> stream
+ *
+ * Autolinks the next chunk of text, and writes to the IO everything
+ * that can be linked so far. A chunk can end anywhere, even in the
+ * middle of a multibyte character.
+ */
+static VALUE
+rb_stream_write(VALUE self, VALUE rb_text)
+{
+	struct stream_data *data = rb_stream_get(self);
+	rb_encoding *encoding;
+
+	Check_Type(rb_text, T_STRING);
+	encoding = rb_enc_get(rb_text);
+
+	if (!rb_enc_asciicompat(encoding))
+		rb_raise(rb_eArgError, "Invalid encoding");
+
+	data->cbdata.encoding = encoding;
+	stream_write(data, rb_text);
+	return LONG2NUM(RSTRING_LEN(rb_text));
+}
+
+static VALUE
+rb_stream_append(VALUE self, VALUE rb_text)
+{
+	rb_stream_write(self, rb_text);
+	return self;
+}
+
+/*
+ * Document-method: Rinku::Stream#finish
+ *
+ * call-seq:
+ *  finish -> io
+ *
+ * Autolinks and writes out the text that is still held back. The stream
+ * can be used for a new document afterwards.
+ */
+static VALUE
+rb_stream_finish(VALUE self)
+{
+	struct stream_data *data = rb_stream_get(self);
+
+	stream_write(data, Qnil);
+	return data->rb_io;
+}
+
+struct linker_data {
+	struct rinku_options opts;
+	struct rinku_compiled compiled;
+	struct rinku_template url_template;
+	struct rinku_template email_template;
+	struct rinku_policy domains;
+	VALUE rb_html;
+	VALUE rb_skip;
+	int ready;
+};
+
+static void
+rb_linker_mark(void *ptr)
+{
+	struct linker_data *data = ptr;
+	rinku_mark_pinned(data->rb_html, data->rb_skip);
+}
+
+static void
+rb_linker_free(void *ptr)
+{
+	struct linker_data *data = ptr;
+
+	if (data->ready)
+		rinku_compiled_free(&data->compiled);
+
+	/* these may be compiled even if the Linker never got ready */
+	rinku_template_free(&data->url_template);
+	rinku_template_free(&data->email_template);
+	rinku_policy_free(&data->domains);
+	xfree(data);
+}
+
+static const rb_data_type_t rb_linker_type = {
+	"Rinku::Linker",
+	{ rb_linker_mark, rb_linker_free, NULL, },
+	NULL, NULL, RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+static VALUE
+rb_linker_alloc(VALUE klass)
+{
+	struct linker_data *data;
+	VALUE self = TypedData_Make_Struct(klass,
+		struct linker_data, &rb_linker_type, data);
+
+	data->rb_html = data->rb_skip = Qnil;
+	rinku_policy_init(&data->domains);
+	return self;
+}
+
+static struct linker_data *
+rb_linker_get(VALUE self)
+{
+	struct linker_data *data;
+	TypedData_Get_Struct(self, struct linker_data, &rb_linker_type, data);
+
+	if (!data->ready)
+		rb_raise(rb_eArgError, "uninitialized linker");
+
+	return data;
+}
+
+/* Compiles the template `rb_source`, if not nil, for a Linker */
+static const struct rinku_template *
+linker_template_load(struct rinku_template *tpl, VALUE rb_source, const char *name)
+{
+	size_t error_pos;
+	int error;
+
+	if (NIL_P(rb_source))
+		return NULL;
+
+	Check_Type(rb_source, T_STRING);
+	error = rinku_template_compile(tpl,
+		RSTRING_PTR(rb_source), RSTRING_LEN(rb_source), &error_pos);
+
+	if (error == -1)
+		rb_memerror();
+
+	if (error < 0)
+		rb_raise(rb_eArgError, "invalid placeholder in %s at offset %lu",
+			name, (unsigned long)error_pos);
+
+	return tpl;
+}
+
+struct domains_load {
+	struct rinku_policy *policy;
+	int templated;
+};
+
+static int
+linker_domain_i(VALUE rb_domain, VALUE rb_rule, VALUE arg)
+{
+	struct domains_load *load = (struct domains_load *)arg;
+	rinku_policy_action action;
+	const char *attrs = NULL;
+	size_t attr_len = 0;
+	int error;
+
+	Check_Type(rb_domain, T_STRING);
+
+	if (rb_rule == Qtrue) {
+		action = RINKU_POLICY_LINK;
+	} else if (!RTEST(rb_rule)) {
+		action = RINKU_POLICY_SKIP;
+	} else if (RB_TYPE_P(rb_rule, T_STRING)) {
+		if (load->templated)
+			rb_raise(rb_eArgError,
+				"the attributes of a domain can't be combined with a template");
+
+		action = RINKU_POLICY_ATTRS;
+		attrs = RSTRING_PTR(rb_rule);
+		attr_len = RSTRING_LEN(rb_rule);
+	} else {
+		rb_raise(rb_eTypeError,
+			"the rule for a domain must be true, false or a String of attributes");
+	}
+
+	error = rinku_policy_add(load->policy,
+		RSTRING_PTR(rb_domain), RSTRING_LEN(rb_domain),
+		action, attrs, attr_len);
+
+	if (error == -1)
+		rb_memerror();
+
+	if (error < 0)
+		rb_raise(rb_eArgError, "invalid domain: %"PRIsVALUE, rb_domain);
+
+	return ST_CONTINUE;
+}
+
+/* Compiles the Hash of domain rules `rb_domains`, if not nil, for a
+ * Linker */
+static const struct rinku_policy *
+linker_domains_load(struct rinku_policy *policy, VALUE rb_domains, int templated)
+{
+	struct domains_load load;
+
+	if (NIL_P(rb_domains))
+		return NULL;
+
+	Check_Type(rb_domains, T_HASH);
+	load.policy = policy;
+	load.templated = templated;
+	rb_hash_foreach(rb_domains, linker_domain_i, (VALUE)&load);
+
+	return policy;
+}
+
+/*
+ * Document-method: Rinku::Linker.new
+ *
+ * call-seq:
+ *  Linker.new(mode: :all, link_attr: nil, skip_tags: nil, flags: 0,
+ *             max_bytes: nil, max_links: nil, timeout: nil,
+ *             template: nil, email_template: nil, domains: nil)
+ *
+ * Compiles a set of linking options once, so they can be reused for any
+ * number of texts. The options mean the same as the arguments of
+ * `Rinku.auto_link`; when `skip_tags` is not given, the value of
+ * `Rinku.skip_tags` at the time the Linker is created is used.
+ *
+ * `template` replaces the whole `<a>` of every link, and can't be
+ * combined with `link_attr`. Its placeholders are:
+ *
+ * -   `{href}`: the link with its scheme (`http://` for `www.` links,
+ * `mailto:` for email addresses), quoted for use in an attribute
+ * -   `{text}`: the link as it appears in the text, or what the block
+ * returns for it
+ * -   `{text:N}`: the same, cut down to at most N characters with an
+ * ellipsis in the middle; an HTML entity counts as one character
+ * -   `{kind}`: `url`, `www` or `email`
+ *
+ * `{{` and `}}` stand for literal braces. `email_template` is used
+ * instead of `template` for email addresses, e.g.
+ *
+ *      ~~~~~ruby
+ *      Rinku::Linker.new(
+ *        template: '<a href="{href}" rel="nofollow">{text:32}</a>',
+ *        email_template: '<a href="{href}" class="email">{text}</a>')
+ *      ~~~~~
+ *
+ * `domains` is a Hash of rules for the hosts of the links, checked
+ * right after each link is found. The rule for a domain also applies
+ * to all of its subdomains, and `"*"` matches every host no other rule
+ * does; when several rules match, the one for the longest domain wins.
+ * A rule is either `true`, to link as usual; `false`, to leave the link
+ * as text; or a String with the attributes for its links, instead of
+ * `link_attr`. The rules are compiled into a trie of domain labels, so
+ * checking a link costs the same however many rules there are:
+ *
+ *      ~~~~~ruby
+ *      Rinku::Linker.new(
+ *        link_attr: 'rel="nofollow ugc"',
+ *        domains: {
+ *          "example.com" => 'class="internal"',
+ *          "spam.test" => false,
+ *        })
+ *      ~~~~~
+ *
+ * Linkers are frozen and shareable, so they can be used from any
+ * thread or Ractor.
+ */
+static VALUE
+rb_linker_initialize(int argc, VALUE *argv, VALUE self)
+{
+	const ID *keywords = id_linker_keywords;
+	VALUE rb_kwargs, rb_limits, values[10];
+	const struct rinku_template *url_template, *email_template;
+	const struct rinku_policy *domains;
+	struct linker_data *data;
+	int i;
+
+	TypedData_Get_Struct(self, struct linker_data, &rb_linker_type, data);
+	if (data->ready)
+		rb_raise(rb_eArgError, "linker already initialized");
+
+	rb_scan_args(argc, argv, ":", &rb_kwargs);
+	rb_get_kwargs(rb_kwargs, keywords, 0, 10, values);
+	for (i = 0; i < 10; ++i) {
+		if (values[i] == Qundef)
+			values[i] = Qnil;
+	}
+
+	if (!NIL_P(values[1]) && !(NIL_P(values[7]) && NIL_P(values[8])))
+		rb_raise(rb_eArgError, "link_attr can't be combined with a template");
+
+	/* the budgets go through the same parser as auto_link's */
+	rb_limits = rb_hash_new();
+	for (i = 4; i < 7; ++i)
+		rb_hash_aset(rb_limits, ID2SYM(keywords[i]), values[i]);
+
+	/* before the options, which point into them */
+	url_template = linker_template_load(&data->url_template,
+		values[7], "template");
+	email_template = linker_template_load(&data->email_template,
+		values[8], "email_template");
+	domains = linker_domains_load(&data->domains, values[9],
+		url_template || email_template);
+
+	autolink_args_load(&data->opts, values[0],
+		&values[1], &values[2], values[3], 1, NULL);
+	autolink_limits_load(&data->opts, rb_limits);
+	data->opts.url_template = url_template;
+	data->opts.email_template = email_template;
+	data->opts.domains = domains;
+
+	if (rinku_compile(&data->compiled, &data->opts) < 0) {
+		rinku_compiled_free(&data->compiled);
+		rb_memerror();
+	}
+
+	data->opts.compiled = &data->compiled;
+	data->rb_html = values[1];
+	data->rb_skip = values[2];
+	data->ready = 1;
+
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	/* everything it holds is frozen, so it can go to any Ractor */
+	rb_ractor_make_shareable(self);
+#else
+	rb_obj_freeze(self);
+#endif
+	return self;
+}
+
+/*
+ * Document-method: Rinku::Linker#auto_link
+ *
+ * call-seq:
+ *  auto_link(text) -> String
+ *  auto_link(text) { |link_text| ... } -> String
+ *
+ * Same as `Rinku.auto_link`, with the options of this Linker.
+ */
+static VALUE
+rb_linker_autolink(int argc, VALUE *argv, VALUE self)
+{
+	struct linker_data *data = rb_linker_get(self);
+	VALUE rb_text, rb_block;
+
+	rb_scan_args(argc, argv, "1&", &rb_text, &rb_block);
+	validate_encoding(rb_text);
+
+	if (autolink_use_nogvl(rb_text, rb_block))
+		return rb_ary_entry(
+			autolink_batch(rb_ary_new3(1, rb_text), &data->opts), 0);
+
+	if (NIL_P(rb_block))
+		return autolink_text_ctx(thread_ctx_get(), rb_text, &data->opts);
+
+	return autolink_text(rb_text, &data->opts, rb_block);
+}
+
+/*
+ * Document-method: Rinku::Linker#auto_link_many
+ *
+ * call-seq:
+ *  auto_link_many(texts) -> Array
+ *
+ * Same as `Rinku.auto_link_many`, with the options of this Linker.
+ */
+static VALUE
+rb_linker_autolink_many(VALUE self, VALUE rb_texts)
+{
+	struct linker_data *data = rb_linker_get(self);
+	long i;
+
+	Check_Type(rb_texts, T_ARRAY);
+	rb_texts = rb_ary_dup(rb_texts);
+
+	for (i = 0; i < RARRAY_LEN(rb_texts); ++i)
+		validate_encoding(rb_ary_entry(rb_texts, i));
+
+	return autolink_batch(rb_texts, &data->opts);
+}
+
+void RUBY_EXPORT Init_rinku()
+{
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	rb_ext_ractor_safe(true);
+#endif
+
+	/* before any thread, Ractor or batch worker can scan */
+	scan_init();
+
+	id_call = rb_intern("call");
+	id_safe_concat = rb_intern("safe_concat");
+	id_append = rb_intern("<<");
+	id_thread_ctx = rb_intern("__rinku_thread_ctx__");
+	id_current = rb_intern("current");
+	id_main = rb_intern("main");
+
+	id_all = rb_intern("all");
+	id_email_addresses = rb_intern("email_addresses");
+	id_urls = rb_intern("urls");
+
+	id_limits[0] = rb_intern("max_bytes");
+	id_limits[1] = rb_intern("max_links");
+	id_limits[2] = rb_intern("timeout");
+
+	id_linker_keywords[0] = rb_intern("mode");
+	id_linker_keywords[1] = rb_intern("link_attr");
+	id_linker_keywords[2] = rb_intern("skip_tags");
+	id_linker_keywords[3] = rb_intern("flags");
+	memcpy(&id_linker_keywords[4], id_limits, sizeof(id_limits));
+	id_linker_keywords[7] = rb_intern("template");
+	id_linker_keywords[8] = rb_intern("email_template");
+	id_linker_keywords[9] = rb_intern("domains");
+
+	rb_nativethread_lock_initialize(&g_stats_lock);
+	rb_nativethread_lock_initialize(&g_skip_tags_lock);
+	rb_gc_register_address(&g_skip_tags);
+
+	rb_mRinku = rb_define_module("Rinku");
+	rb_define_module_function(rb_mRinku, "auto_link", rb_rinku_autolink, -1);
+	rb_define_module_function(rb_mRinku, "auto_link!", rb_rinku_autolink_bang, -1);
+	rb_define_module_function(rb_mRinku, "auto_link_into", rb_rinku_autolink_into, -1);
+	rb_define_module_function(rb_mRinku, "auto_link_many", rb_rinku_autolink_many, -1);
+	rb_define_module_function(rb_mRinku, "each_link", rb_rinku_each_link, -1);
+	rb_define_module_function(rb_mRinku, "link_offsets", rb_rinku_link_offsets, -1);
+	rb_define_module_function(rb_mRinku, "skip_tags", rb_rinku_skip_tags, 0);
+	rb_define_module_function(rb_mRinku, "skip_tags=", rb_rinku_set_skip_tags, 1);
+	rb_define_module_function(rb_mRinku, "nogvl_threshold", rb_rinku_nogvl_threshold, 0);
+	rb_define_module_function(rb_mRinku, "nogvl_threshold=", rb_rinku_set_nogvl_threshold, 1);
+	rb_define_module_function(rb_mRinku, "parallel_threshold", rb_rinku_parallel_threshold, 0);
+	rb_define_module_function(rb_mRinku, "parallel_threshold=", rb_rinku_set_parallel_threshold, 1);
+	rb_define_module_function(rb_mRinku, "collect_stats", rb_rinku_collect_stats, 0);
+	rb_define_module_function(rb_mRinku, "collect_stats=", rb_rinku_set_collect_stats, 1);
+	rb_define_module_function(rb_mRinku, "last_stats", rb_rinku_last_stats, 0);
+	rb_define_module_function(rb_mRinku, "stats", rb_rinku_stats, 0);
+	rb_define_module_function(rb_mRinku, "reset_stats", rb_rinku_reset_stats, 0);
+	rb_define_module_function(rb_mRinku, "truncated?", rb_rinku_truncated_p, 0);
+	g_link_kinds[RINKU_LINK_WWW] = ID2SYM(rb_intern("www"));
+	g_link_kinds[RINKU_LINK_EMAIL] = ID2SYM(rb_intern("email"));
+	g_link_kinds[RINKU_LINK_URL] = ID2SYM(rb_intern("url"));
+
+	rb_define_const(rb_mRinku, "AUTOLINK_SHORT_DOMAINS", INT2FIX(AUTOLINK_SHORT_DOMAINS));
+	rb_define_const(rb_mRinku, "AUTOLINK_EXACT_SIZE", INT2FIX(AUTOLINK_EXACT_SIZE));
+	rb_define_const(rb_mRinku, "AUTOLINK_ESCAPE_HTML", INT2FIX(AUTOLINK_ESCAPE_HTML));
+	rb_define_const(rb_mRinku, "AUTOLINK_MEMOIZE", INT2FIX(AUTOLINK_MEMOIZE));
+	rb_define_const(rb_mRinku, "AUTOLINK_BATCH_CALLBACK", INT2FIX(AUTOLINK_BATCH_CALLBACK));
+
+	rb_cStream = rb_define_class_under(rb_mRinku, "Stream", rb_cObject);
+	rb_define_alloc_func(rb_cStream, rb_stream_alloc);
+	rb_define_method(rb_cStream, "initialize", rb_stream_initialize, -1);
+	rb_define_method(rb_cStream, "write", rb_stream_write, 1);
+	rb_define_method(rb_cStream, "<<", rb_stream_append, 1);
+	rb_define_method(rb_cStream, "finish", rb_stream_finish, 0);
+
+	rb_cLinker = rb_define_class_under(rb_mRinku, "Linker", rb_cObject);
+	rb_define_alloc_func(rb_cLinker, rb_linker_alloc);
+	rb_define_method(rb_cLinker, "initialize", rb_linker_initialize, -1);
+	rb_define_method(rb_cLinker, "auto_link", rb_linker_autolink, -1);
+	rb_define_method(rb_cLinker, "auto_link_many", rb_linker_autolink_many, 1);
 }
 
@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#	define SCAN_X86 1
+#	include <immintrin.h>
+#	if defined(__clang__) || __GNUC__ >= 5
+#		define SCAN_AVX512 1
+#	endif
+#endif
+
+/* The most bytes the narrow kernels look for */
+#define SCAN_NARROW 5
+
+typedef size_t (*scan_find_fn)(
+	const struct scan_set *, const uint8_t *, size_t, size_t);
+
+static size_t
+scan_find_scalar(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	while (pos < size && !set->table[data[pos]] && !(data[pos] & set->high))
+		pos++;
+
+	return pos;
+}
+
+#ifdef SCAN_X86
+__attribute__ ((target("sse2")))
+static size_t
+scan_find_sse2(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m128i n0 = _mm_set1_epi8((char)set->bytes[0]);
+	const __m128i n1 = _mm_set1_epi8((char)set->bytes[1]);
+	const __m128i n2 = _mm_set1_epi8((char)set->bytes[2]);
+	const __m128i n3 = _mm_set1_epi8((char)set->bytes[3]);
+	const __m128i n4 = _mm_set1_epi8((char)set->bytes[4]);
+
+	while (pos + 16 <= size) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + pos));
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_cmpeq_epi8(v, n1)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, n2), _mm_cmpeq_epi8(v, n3)));
+		int mask = _mm_movemask_epi8(_mm_or_si128(m, _mm_cmpeq_epi8(v, n4)));
+
+		if (mask)
+			return pos + __builtin_ctz(mask);
+
+		pos += 16;
+	}
+
+	return scan_find_scalar(set, data, pos, size);
+}
+
+__attribute__ ((target("avx2")))
+static size_t
+scan_find_avx2(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m256i n0 = _mm256_set1_epi8((char)set->bytes[0]);
+	const __m256i n1 = _mm256_set1_epi8((char)set->bytes[1]);
+	const __m256i n2 = _mm256_set1_epi8((char)set->bytes[2]);
+	const __m256i n3 = _mm256_set1_epi8((char)set->bytes[3]);
+	const __m256i n4 = _mm256_set1_epi8((char)set->bytes[4]);
+
+	while (pos + 32 <= size) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + pos));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, n0), _mm256_cmpeq_epi8(v, n1)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, n2), _mm256_cmpeq_epi8(v, n3)));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+			_mm256_or_si256(m, _mm256_cmpeq_epi8(v, n4)));
+
+		if (mask)
+			return pos + __builtin_ctz(mask);
+
+		pos += 32;
+	}
+
+	/* The SSE2 kernel is not VEX-encoded; running it with the upper
+	 * halves of the registers dirty costs far more than the scan */
+	_mm256_zeroupper();
+	return scan_find_sse2(set, data, pos, size);
+}
+
+#ifdef SCAN_AVX512
+__attribute__ ((target("avx512f,avx512bw")))
+static size_t
+scan_find_avx512(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m512i n0 = _mm512_set1_epi8((char)set->bytes[0]);
+	const __m512i n1 = _mm512_set1_epi8((char)set->bytes[1]);
+	const __m512i n2 = _mm512_set1_epi8((char)set->bytes[2]);
+	const __m512i n3 = _mm512_set1_epi8((char)set->bytes[3]);
+	const __m512i n4 = _mm512_set1_epi8((char)set->bytes[4]);
+
+	while (pos + 64 <= size) {
+		__m512i v = _mm512_loadu_si512((const void *)(data + pos));
+		uint64_t mask =
+			_mm512_cmpeq_epi8_mask(v, n0) | _mm512_cmpeq_epi8_mask(v, n1) |
+			_mm512_cmpeq_epi8_mask(v, n2) | _mm512_cmpeq_epi8_mask(v, n3) |
+			_mm512_cmpeq_epi8_mask(v, n4);
+
+		if (mask)
+			return pos + __builtin_ctzll(mask);
+
+		pos += 64;
+	}
+
+	return scan_find_avx2(set, data, pos, size);
+}
+#endif
+#endif
+
+/* The same, for sets of more than SCAN_NARROW bytes or with `high` */
+#ifdef SCAN_X86
+__attribute__ ((target("sse2")))
+static size_t
+scan_find_sse2_wide(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m128i n0 = _mm_set1_epi8((char)set->bytes[0]);
+	const __m128i n1 = _mm_set1_epi8((char)set->bytes[1]);
+	const __m128i n2 = _mm_set1_epi8((char)set->bytes[2]);
+	const __m128i n3 = _mm_set1_epi8((char)set->bytes[3]);
+	const __m128i n4 = _mm_set1_epi8((char)set->bytes[4]);
+	const __m128i n5 = _mm_set1_epi8((char)set->bytes[5]);
+	const __m128i n6 = _mm_set1_epi8((char)set->bytes[6]);
+	const __m128i n7 = _mm_set1_epi8((char)set->bytes[7]);
+	const __m128i high = _mm_set1_epi8((char)set->high);
+
+	while (pos + 16 <= size) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(data + pos));
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_cmpeq_epi8(v, n1)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, n2), _mm_cmpeq_epi8(v, n3))),
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, n4), _mm_cmpeq_epi8(v, n5)),
+				_mm_or_si128(_mm_cmpeq_epi8(v, n6), _mm_cmpeq_epi8(v, n7))));
+		/* only the top bit of each byte counts */
+		int mask = _mm_movemask_epi8(_mm_or_si128(m, _mm_and_si128(v, high)));
+
+		if (mask)
+			return pos + __builtin_ctz(mask);
+
+		pos += 16;
+	}
+
+	return scan_find_scalar(set, data, pos, size);
+}
+
+__attribute__ ((target("avx2")))
+static size_t
+scan_find_avx2_wide(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m256i n0 = _mm256_set1_epi8((char)set->bytes[0]);
+	const __m256i n1 = _mm256_set1_epi8((char)set->bytes[1]);
+	const __m256i n2 = _mm256_set1_epi8((char)set->bytes[2]);
+	const __m256i n3 = _mm256_set1_epi8((char)set->bytes[3]);
+	const __m256i n4 = _mm256_set1_epi8((char)set->bytes[4]);
+	const __m256i n5 = _mm256_set1_epi8((char)set->bytes[5]);
+	const __m256i n6 = _mm256_set1_epi8((char)set->bytes[6]);
+	const __m256i n7 = _mm256_set1_epi8((char)set->bytes[7]);
+	const __m256i high = _mm256_set1_epi8((char)set->high);
+
+	while (pos + 32 <= size) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(data + pos));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, n0), _mm256_cmpeq_epi8(v, n1)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, n2), _mm256_cmpeq_epi8(v, n3))),
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, n4), _mm256_cmpeq_epi8(v, n5)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, n6), _mm256_cmpeq_epi8(v, n7))));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+			_mm256_or_si256(m, _mm256_and_si256(v, high)));
+
+		if (mask)
+			return pos + __builtin_ctz(mask);
+
+		pos += 32;
+	}
+
+	/* The SSE2 kernel is not VEX-encoded; running it with the upper
+	 * halves of the registers dirty costs far more than the scan */
+	_mm256_zeroupper();
+	return scan_find_sse2_wide(set, data, pos, size);
+}
+
+#ifdef SCAN_AVX512
+__attribute__ ((target("avx512f,avx512bw")))
+static size_t
+scan_find_avx512_wide(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	const __m512i n0 = _mm512_set1_epi8((char)set->bytes[0]);
+	const __m512i n1 = _mm512_set1_epi8((char)set->bytes[1]);
+	const __m512i n2 = _mm512_set1_epi8((char)set->bytes[2]);
+	const __m512i n3 = _mm512_set1_epi8((char)set->bytes[3]);
+	const __m512i n4 = _mm512_set1_epi8((char)set->bytes[4]);
+	const __m512i n5 = _mm512_set1_epi8((char)set->bytes[5]);
+	const __m512i n6 = _mm512_set1_epi8((char)set->bytes[6]);
+	const __m512i n7 = _mm512_set1_epi8((char)set->bytes[7]);
+	const uint64_t high = set->high ? ~(uint64_t)0 : 0;
+
+	while (pos + 64 <= size) {
+		__m512i v = _mm512_loadu_si512((const void *)(data + pos));
+		uint64_t mask =
+			_mm512_cmpeq_epi8_mask(v, n0) | _mm512_cmpeq_epi8_mask(v, n1) |
+			_mm512_cmpeq_epi8_mask(v, n2) | _mm512_cmpeq_epi8_mask(v, n3) |
+			_mm512_cmpeq_epi8_mask(v, n4) | _mm512_cmpeq_epi8_mask(v, n5) |
+			_mm512_cmpeq_epi8_mask(v, n6) | _mm512_cmpeq_epi8_mask(v, n7) |
+			(_mm512_movepi8_mask(v) & high);
+
+		if (mask)
+			return pos + __builtin_ctzll(mask);
+
+		pos += 64;
+	}
+
+	return scan_find_avx2_wide(set, data, pos, size);
+}
+#endif
+#endif
+
+/* Picked from CPUID by scan_init, narrow and wide; the scalar kernel
+ * until then */
+static scan_find_fn scan_find_impl[2] = {
+	&scan_find_scalar, &scan_find_scalar
+};
+
+void
+scan_init(void)
+{
+	scan_find_fn narrow = &scan_find_scalar, wide = &scan_find_scalar;
+
+#ifdef SCAN_X86
+	__builtin_cpu_init();
+
+#ifdef SCAN_AVX512
+	if (__builtin_cpu_supports("avx512bw")) {
+		narrow = &scan_find_avx512;
+		wide = &scan_find_avx512_wide;
+	} else
+#endif
+	if (__builtin_cpu_supports("avx2")) {
+		narrow = &scan_find_avx2;
+		wide = &scan_find_avx2_wide;
+	} else if (__builtin_cpu_supports("sse2")) {
+		narrow = &scan_find_sse2;
+		wide = &scan_find_sse2_wide;
+	}
+#endif
+
+	scan_find_impl[0] = narrow;
+	scan_find_impl[1] = wide;
+}
+
+size_t
+scan_find(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size)
+{
+	/* the vector kernels need at least one needle to pad with */
+	if (set->count == 0)
+		return set->high ? scan_find_scalar(set, data, pos, size) : size;
+
+	return scan_find_impl[set->count > SCAN_NARROW || set->high](
+		set, data, pos, size);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef RINKU_SCAN_H
+#define RINKU_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SCAN_SET_MAX 8
+
+/* struct scan_set: a small set of bytes to look for in a buffer. Sets
+ * that are known in advance can be static; pad `bytes` with copies of
+ * its first entry. */
+struct scan_set {
+	uint8_t table[256];		/* membership table for the scalar path */
+	uint8_t bytes[SCAN_SET_MAX];	/* needles for the vector paths */
+	size_t count;
+	uint8_t high;			/* 0x80 to also find every non-ASCII byte */
+};
+
+/* scan_init: picks the fastest kernels this CPU supports. Call it once,
+ * before any thread scans; until then the scalar kernel is used. */
+void scan_init(void);
+
+/* scan_find: position of the first byte in the set at or after `pos`,
+ * or `size` if there is none */
+size_t scan_find(const struct scan_set *set,
+	const uint8_t *data, size_t pos, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
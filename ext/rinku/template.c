@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "template.h"
+#include "utf8.h"
+
+/* The longest `N` in `{text:N}` */
+#define TEMPLATE_TEXT_MAX 9999
+
+/* The longest name of an HTML entity we won't split */
+#define TEMPLATE_ENTITY_MAX 32
+
+static int
+template_push(struct rinku_template *tpl, template_opcode code,
+	size_t offset, size_t length)
+{
+	struct template_op *op;
+
+	/* the previous op is still open if it's text too */
+	if (code == TEMPLATE_LITERAL && tpl->count > 0 &&
+		tpl->ops[tpl->count - 1].code == TEMPLATE_LITERAL) {
+		tpl->ops[tpl->count - 1].length += length;
+		return 0;
+	}
+
+	if ((tpl->count & (tpl->count - 1)) == 0) {
+		size_t capa = tpl->count ? tpl->count * 2 : 4;
+		struct template_op *ops = realloc(tpl->ops, capa * sizeof(*ops));
+
+		if (!ops)
+			return -1;
+		tpl->ops = ops;
+	}
+
+	op = &tpl->ops[tpl->count++];
+	op->code = code;
+	op->offset = offset;
+	op->length = length;
+	return 0;
+}
+
+static int
+template_push_literal(struct rinku_template *tpl, const char *data, size_t size)
+{
+	size_t offset = tpl->literals.size;
+
+	if (size == 0)
+		return 0;
+
+	if (bufgrow(&tpl->literals, offset + size) != BUF_OK)
+		return -1;
+
+	bufput(&tpl->literals, data, size);
+	return template_push(tpl, TEMPLATE_LITERAL, offset, size);
+}
+
+/* Parses the name of a placeholder, without its braces, into `code`
+ * and `length` */
+static bool
+template_placeholder(const char *name, size_t len,
+	template_opcode *code, size_t *length)
+{
+	size_t i;
+
+	*length = 0;
+
+	if (len == 4 && memcmp(name, "href", 4) == 0) {
+		*code = TEMPLATE_HREF;
+		return true;
+	}
+
+	if (len == 4 && memcmp(name, "kind", 4) == 0) {
+		*code = TEMPLATE_KIND;
+		return true;
+	}
+
+	if (len < 4 || memcmp(name, "text", 4) != 0)
+		return false;
+
+	*code = TEMPLATE_TEXT;
+	if (len == 4)
+		return true;
+
+	if (name[4] != ':' || len == 5)
+		return false;
+
+	for (i = 5; i < len; ++i) {
+		if (!rinku_isdigit(name[i]))
+			return false;
+
+		*length = *length * 10 + (name[i] - '0');
+		if (*length > TEMPLATE_TEXT_MAX)
+			return false;
+	}
+
+	return *length > 0;
+}
+
+int
+rinku_template_compile(struct rinku_template *tpl,
+	const char *source, size_t size, size_t *error_pos)
+{
+	size_t i = 0, mark = 0;
+
+	memset(tpl, 0x0, sizeof(*tpl));
+	tpl->literals.unit = 64;
+
+	while (i < size) {
+		const char *close;
+		template_opcode code;
+		size_t length;
+
+		if (source[i] != '{' && source[i] != '}') {
+			i++;
+			continue;
+		}
+
+		/* `{{` and `}}` are a brace of their own; a lone `}` is too */
+		if (source[i] == '}' || (i + 1 < size && source[i + 1] == '{')) {
+			if (i + 1 < size && source[i + 1] == source[i]) {
+				if (template_push_literal(tpl, source + mark, i + 1 - mark) < 0)
+					return -1;
+				mark = i + 2;
+				i++;
+			}
+
+			i++;
+			continue;
+		}
+
+		if (template_push_literal(tpl, source + mark, i - mark) < 0)
+			return -1;
+
+		close = memchr(source + i, '}', size - i);
+		if (!close || !template_placeholder(source + i + 1,
+				close - source - i - 1, &code, &length)) {
+			*error_pos = i;
+			return -2;
+		}
+
+		if (template_push(tpl, code, 0, length) < 0)
+			return -1;
+
+		i = mark = close - source + 1;
+	}
+
+	return template_push_literal(tpl, source + mark, size - mark);
+}
+
+void
+rinku_template_free(struct rinku_template *tpl)
+{
+	free(tpl->ops);
+	bufreset(&tpl->literals);
+	tpl->ops = NULL;
+	tpl->count = 0;
+}
+
+/* Length of the character or HTML entity at the start of `text` */
+static inline size_t
+template_unit(const uint8_t *text, size_t size)
+{
+	size_t len;
+
+	if (text[0] < 0x80 && text[0] != '&')
+		return 1;
+
+	if (text[0] == '&') {
+		for (len = 1; len < size && len <= TEMPLATE_ENTITY_MAX; ++len) {
+			if (text[len] == ';')
+				return len > 1 ? len + 1 : 1;
+
+			if (!rinku_isalnum(text[len]) && text[len] != '#')
+				break;
+		}
+
+		return 1;
+	}
+
+	len = RINKU_CHAR_UTF8_LEN(rinku_char_class[text[0]]);
+	if (len == 0)
+		len = 1;
+
+	return len < size ? len : size;
+}
+
+bool
+rinku_template_shorten(const uint8_t *text, size_t size, size_t max_chars,
+	size_t *head, size_t *tail)
+{
+	size_t head_chars, tail_chars, count = 0, i = 0, n;
+
+	/* no text has more characters than bytes */
+	if (max_chars == 0 || size <= max_chars)
+		return false;
+
+	while (i < size) {
+		i += template_unit(text + i, size - i);
+		count++;
+	}
+
+	if (count <= max_chars)
+		return false;
+
+	/* the ellipsis takes one of the characters */
+	tail_chars = (max_chars - 1) / 2;
+	head_chars = max_chars - 1 - tail_chars;
+
+	/* there are more than head_chars + tail_chars, so the head is
+	 * always found on the way to the tail */
+	for (i = 0, n = 0; n < count - tail_chars; ++n) {
+		if (n == head_chars)
+			*head = i;
+
+		i += template_unit(text + i, size - i);
+	}
+
+	*tail = i;
+	return true;
+}
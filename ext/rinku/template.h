@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016, GitHub, Inc
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+#ifndef RINKU_TEMPLATE_H
+#define RINKU_TEMPLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What a template can ask for, besides its own text */
+typedef enum {
+	TEMPLATE_LITERAL = 0,	/* `length` bytes of `literals` from `offset` */
+	TEMPLATE_HREF,		/* `{href}`: the link with its scheme, for an attribute */
+	TEMPLATE_TEXT,		/* `{text}` or `{text:N}`: the link as it appears */
+	TEMPLATE_KIND,		/* `{kind}`: `url`, `www` or `email` */
+} template_opcode;
+
+struct template_op {
+	template_opcode code;
+	size_t offset;
+	size_t length;		/* for `{text:N}`, N; 0 to never shorten */
+};
+
+/* struct rinku_template: the HTML of a link, compiled from a template
+ * such as `<a href="{href}" rel="nofollow">{text:40}</a>` */
+struct rinku_template {
+	struct template_op *ops;
+	size_t count;
+	struct buf literals;
+};
+
+/* rinku_template_compile: compiles `source` into `tpl`; `{{` and `}}`
+ * stand for a single brace. Returns 0; -1 if out of memory; or -2 if
+ * there is an unknown or unclosed placeholder at `*error_pos`. The
+ * template must be freed whatever the result. */
+int
+rinku_template_compile(struct rinku_template *tpl,
+	const char *source, size_t size, size_t *error_pos);
+
+void
+rinku_template_free(struct rinku_template *tpl);
+
+/* rinku_template_shorten: for `{text:N}`, where the link text must be
+ * cut so it is at most `max_chars` characters with the ellipsis in the
+ * middle. Returns false if it fits as it is; otherwise the head is
+ * `text[0, *head)` and the tail `text[*tail, size)`. HTML entities
+ * count as one character and are never split. */
+bool
+rinku_template_shorten(const uint8_t *text, size_t size, size_t max_chars,
+	size_t *head, size_t *tail);
+
+/* The ellipsis between the head and the tail of a shortened text */
+#define TEMPLATE_ELLIPSIS "&hellip;"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/* vim: set filetype=c: */
@@ -0,0 +1,600 @@
+/* Generated by unicode_tables.rb; do not edit by hand */
+#ifndef RINKU_UNICODE_TABLES_H
+#define RINKU_UNICODE_TABLES_H
+
+#define UNICODE_VERSION "15.0.0"
+#define UNICODE_TABLE_LIMIT 0x1EA00
+
+enum {
+	UNICODE_SPACE,
+	UNICODE_PUNCT,
+	UNICODE_CLASSES
+};
+
+/* index into unicode_stage2 of each block of 256 codepoints */
+static const uint8_t unicode_stage1[490] = {
+	0, 1, 1, 2, 1, 3, 4, 5, 6, 7, 8, 1, 9, 10, 11, 12,
+	13, 1, 1, 14, 15, 1, 16, 17, 18, 19, 20, 21, 22, 1, 1, 1,
+	23, 1, 1, 24, 1, 1, 1, 25, 1, 26, 1, 1, 27, 28, 29, 1,
+	30, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 31, 1, 32, 1, 33, 34, 35, 36, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 37, 38, 39,
+	1, 40, 1, 41, 1, 42, 1, 1, 43, 44, 45, 46, 1, 1, 47, 48,
+	49, 50, 51, 1, 52, 53, 54, 55, 56, 57, 58, 59, 60, 1, 61, 62,
+	1, 1, 1, 1, 63, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 64,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 65, 66, 1, 1, 67, 68,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 69, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 70, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 71,
+};
+
+static const uint32_t unicode_stage2[72][UNICODE_CLASSES][8] = {
+	{
+		{0x00003600, 0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x00000000},
+		{0x00000000, 0xfc00fffe, 0xf8000001, 0x78000001, 0x00000000, 0x88c00882, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x40000000, 0x00000080, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0xfc000000, 0x00000000, 0x00000600, 0x40000000, 0x00000049, 0x00180000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0xe8003600, 0x00000000, 0x00000000, 0x00003c00, 0x00000000, 0x00000000, 0x00100000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00003fff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x03800000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x7fff0000, 0x40000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00010030, 0x00000000, 0x00000000, 0x00000000, 0x20000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00400000, 0x00000000, 0x00000000, 0x00000000, 0x00010000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00800000, 0x00000010, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00100000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0c008000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x0017fff0, 0x3c000000, 0x00000000, 0x00000000, 0x00000020, 0x00000000, 0x061f0000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0000fc00, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x08000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x000001ff, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00004000, 0x18000000, 0x00000000, 0x00000000, 0x00003800},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00600000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07700000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x000007ff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000030, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0xc0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00003f7f, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0xfc000000, 0x60000001, 0x00000000, 0x00000000, 0x00000000, 0xf0000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0xf8000000, 0x00000000, 0xc0000000, 0x00000000, 0x00000000, 0x000800ff, 0x00000000},
+	},
+	{
+		{0x000007ff, 0x00008000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0xffff0000, 0xffff00ff, 0x7ffbffef, 0x60000000, 0x00006000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000f00, 0x00000600, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x003fff00, 0x00000000, 0x00000000, 0x00000060, 0x0000ffc0},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x01fffff8, 0x00000000, 0x0f000000, 0x30000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xde000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00010000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0xffffffff, 0xffff7fff, 0x3ffcffff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000001, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0xfff3ff0e, 0x20010000, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000000, 0x08000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xc0000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x0000e000, 0x00000000, 0x00000000, 0x40080000, 0x00000000, 0x00000000, 0x00000000, 0x00fc0000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00f00000, 0x00000000, 0x00000000, 0x0000c000, 0x17000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x0000c000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0xc0003ffe, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0xf0000000, 0x00000000, 0x00000000, 0x00000000, 0xc0000000, 0x00030000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000800},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0xc0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x03ff0000, 0xffff0000, 0xfff7ffff, 0x00000d0b, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x8c00f7ee, 0xb8000001, 0xa8000000, 0x0000003f, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000007, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000000, 0x00000000, 0x00010000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00008000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x80000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x01ff0000, 0x80000000, 0x00000000, 0x00000000, 0x00000000, 0x007f0000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0xfe000000, 0x00000000, 0x00000000, 0x1e000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00002000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x03e00000, 0x00000000, 0x000003c0, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00003f80, 0x00000000, 0x00000000, 0xd8000000, 0x00000003, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0000000f, 0x00300000, 0x00000000, 0x00000000, 0xe80021e0, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x3f000000, 0x00000000, 0x00000000, 0x00000000, 0x00000200, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x2c00f800, 0x00000000, 0x00000000, 0x00000000, 0x00000040, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00fffffe, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0000000e, 0x00001fff, 0x00000000, 0x02000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x70000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x08000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000070, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x80000000, 0x0000007f, 0x00000000, 0xdc000000, 0x00000007, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x000003ff, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0000003e, 0x00030000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x01800000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x0000fff8, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x001f0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00060000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x0000c000, 0x00000000, 0x00000000, 0x00000000, 0x00200000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x0f800000, 0x00000010, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07800000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000f80, 0x00000000, 0x00000000, 0x00000000},
+	},
+	{
+		{0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+		{0x00000000, 0x00000000, 0xc0000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000},
+	},
+};
+
+/* what each byte is to the scanners; see RINKU_CHAR_* in utf8.h */
+const uint16_t rinku_char_class[256] = {
+	/* 0x00 */ RINKU_CHAR_UTF8(1),
+	/* 0x01 */ RINKU_CHAR_UTF8(1),
+	/* 0x02 */ RINKU_CHAR_UTF8(1),
+	/* 0x03 */ RINKU_CHAR_UTF8(1),
+	/* 0x04 */ RINKU_CHAR_UTF8(1),
+	/* 0x05 */ RINKU_CHAR_UTF8(1),
+	/* 0x06 */ RINKU_CHAR_UTF8(1),
+	/* 0x07 */ RINKU_CHAR_UTF8(1),
+	/* 0x08 */ RINKU_CHAR_UTF8(1),
+	/* 0x09 */ RINKU_CHAR_SPACE | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x0a */ RINKU_CHAR_SPACE | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x0b */ RINKU_CHAR_SPACE | RINKU_CHAR_UTF8(1),
+	/* 0x0c */ RINKU_CHAR_SPACE | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x0d */ RINKU_CHAR_SPACE | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x0e */ RINKU_CHAR_UTF8(1),
+	/* 0x0f */ RINKU_CHAR_UTF8(1),
+	/* 0x10 */ RINKU_CHAR_UTF8(1),
+	/* 0x11 */ RINKU_CHAR_UTF8(1),
+	/* 0x12 */ RINKU_CHAR_UTF8(1),
+	/* 0x13 */ RINKU_CHAR_UTF8(1),
+	/* 0x14 */ RINKU_CHAR_UTF8(1),
+	/* 0x15 */ RINKU_CHAR_UTF8(1),
+	/* 0x16 */ RINKU_CHAR_UTF8(1),
+	/* 0x17 */ RINKU_CHAR_UTF8(1),
+	/* 0x18 */ RINKU_CHAR_UTF8(1),
+	/* 0x19 */ RINKU_CHAR_UTF8(1),
+	/* 0x1a */ RINKU_CHAR_UTF8(1),
+	/* 0x1b */ RINKU_CHAR_UTF8(1),
+	/* 0x1c */ RINKU_CHAR_UTF8(1),
+	/* 0x1d */ RINKU_CHAR_UTF8(1),
+	/* 0x1e */ RINKU_CHAR_UTF8(1),
+	/* 0x1f */ RINKU_CHAR_UTF8(1),
+	/* 0x20 */ RINKU_CHAR_SPACE | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x21 ! */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x22 " */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x23 # */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x24 $ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x25 % */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x26 & */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x27 ' */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x28 ( */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x29 ) */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x2a * */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x2b + */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x2c , */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x2d - */ RINKU_CHAR_PUNCT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x2e . */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_DOT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x2f / */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x30 0 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x31 1 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x32 2 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x33 3 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x34 4 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x35 5 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x36 6 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x37 7 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x38 8 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x39 9 */ RINKU_CHAR_DIGIT | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x3a : */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_TRIGGER(3) | RINKU_CHAR_UTF8(1),
+	/* 0x3b ; */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x3c < */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_TRIGGER(4) | RINKU_CHAR_UTF8(1),
+	/* 0x3d = */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x3e > */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x3f ? */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x40 @ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_TRIGGER(2) | RINKU_CHAR_UTF8(1),
+	/* 0x41 A */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x42 B */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x43 C */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x44 D */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x45 E */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x46 F */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x47 G */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x48 H */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x49 I */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4a J */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4b K */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4c L */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4d M */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4e N */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x4f O */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x50 P */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x51 Q */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x52 R */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x53 S */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x54 T */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x55 U */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x56 V */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x57 W */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_TRIGGER(1) | RINKU_CHAR_UTF8(1),
+	/* 0x58 X */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x59 Y */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x5a Z */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x5b [ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x5c \ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x5d ] */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x5e ^ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x5f _ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_USCORE | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x60 ` */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x61 a */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x62 b */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x63 c */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x64 d */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x65 e */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x66 f */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x67 g */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x68 h */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x69 i */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6a j */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6b k */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6c l */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6d m */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6e n */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x6f o */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x70 p */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x71 q */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x72 r */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x73 s */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x74 t */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x75 u */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x76 v */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x77 w */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_TRIGGER(1) | RINKU_CHAR_UTF8(1),
+	/* 0x78 x */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x79 y */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x7a z */ RINKU_CHAR_ALPHA | RINKU_CHAR_EMAIL | RINKU_CHAR_UTF8(1),
+	/* 0x7b { */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x7c | */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x7d } */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x7e ~ */ RINKU_CHAR_PUNCT | RINKU_CHAR_HOST_END | RINKU_CHAR_UTF8(1),
+	/* 0x7f */ RINKU_CHAR_UTF8(1),
+	/* 0x80 */ RINKU_CHAR_UTF8(0),
+	/* 0x81 */ RINKU_CHAR_UTF8(0),
+	/* 0x82 */ RINKU_CHAR_UTF8(0),
+	/* 0x83 */ RINKU_CHAR_UTF8(0),
+	/* 0x84 */ RINKU_CHAR_UTF8(0),
+	/* 0x85 */ RINKU_CHAR_UTF8(0),
+	/* 0x86 */ RINKU_CHAR_UTF8(0),
+	/* 0x87 */ RINKU_CHAR_UTF8(0),
+	/* 0x88 */ RINKU_CHAR_UTF8(0),
+	/* 0x89 */ RINKU_CHAR_UTF8(0),
+	/* 0x8a */ RINKU_CHAR_UTF8(0),
+	/* 0x8b */ RINKU_CHAR_UTF8(0),
+	/* 0x8c */ RINKU_CHAR_UTF8(0),
+	/* 0x8d */ RINKU_CHAR_UTF8(0),
+	/* 0x8e */ RINKU_CHAR_UTF8(0),
+	/* 0x8f */ RINKU_CHAR_UTF8(0),
+	/* 0x90 */ RINKU_CHAR_UTF8(0),
+	/* 0x91 */ RINKU_CHAR_UTF8(0),
+	/* 0x92 */ RINKU_CHAR_UTF8(0),
+	/* 0x93 */ RINKU_CHAR_UTF8(0),
+	/* 0x94 */ RINKU_CHAR_UTF8(0),
+	/* 0x95 */ RINKU_CHAR_UTF8(0),
+	/* 0x96 */ RINKU_CHAR_UTF8(0),
+	/* 0x97 */ RINKU_CHAR_UTF8(0),
+	/* 0x98 */ RINKU_CHAR_UTF8(0),
+	/* 0x99 */ RINKU_CHAR_UTF8(0),
+	/* 0x9a */ RINKU_CHAR_UTF8(0),
+	/* 0x9b */ RINKU_CHAR_UTF8(0),
+	/* 0x9c */ RINKU_CHAR_UTF8(0),
+	/* 0x9d */ RINKU_CHAR_UTF8(0),
+	/* 0x9e */ RINKU_CHAR_UTF8(0),
+	/* 0x9f */ RINKU_CHAR_UTF8(0),
+	/* 0xa0 */ RINKU_CHAR_UTF8(0),
+	/* 0xa1 */ RINKU_CHAR_UTF8(0),
+	/* 0xa2 */ RINKU_CHAR_UTF8(0),
+	/* 0xa3 */ RINKU_CHAR_UTF8(0),
+	/* 0xa4 */ RINKU_CHAR_UTF8(0),
+	/* 0xa5 */ RINKU_CHAR_UTF8(0),
+	/* 0xa6 */ RINKU_CHAR_UTF8(0),
+	/* 0xa7 */ RINKU_CHAR_UTF8(0),
+	/* 0xa8 */ RINKU_CHAR_UTF8(0),
+	/* 0xa9 */ RINKU_CHAR_UTF8(0),
+	/* 0xaa */ RINKU_CHAR_UTF8(0),
+	/* 0xab */ RINKU_CHAR_UTF8(0),
+	/* 0xac */ RINKU_CHAR_UTF8(0),
+	/* 0xad */ RINKU_CHAR_UTF8(0),
+	/* 0xae */ RINKU_CHAR_UTF8(0),
+	/* 0xaf */ RINKU_CHAR_UTF8(0),
+	/* 0xb0 */ RINKU_CHAR_UTF8(0),
+	/* 0xb1 */ RINKU_CHAR_UTF8(0),
+	/* 0xb2 */ RINKU_CHAR_UTF8(0),
+	/* 0xb3 */ RINKU_CHAR_UTF8(0),
+	/* 0xb4 */ RINKU_CHAR_UTF8(0),
+	/* 0xb5 */ RINKU_CHAR_UTF8(0),
+	/* 0xb6 */ RINKU_CHAR_UTF8(0),
+	/* 0xb7 */ RINKU_CHAR_UTF8(0),
+	/* 0xb8 */ RINKU_CHAR_UTF8(0),
+	/* 0xb9 */ RINKU_CHAR_UTF8(0),
+	/* 0xba */ RINKU_CHAR_UTF8(0),
+	/* 0xbb */ RINKU_CHAR_UTF8(0),
+	/* 0xbc */ RINKU_CHAR_UTF8(0),
+	/* 0xbd */ RINKU_CHAR_UTF8(0),
+	/* 0xbe */ RINKU_CHAR_UTF8(0),
+	/* 0xbf */ RINKU_CHAR_UTF8(0),
+	/* 0xc0 */ RINKU_CHAR_UTF8(2),
+	/* 0xc1 */ RINKU_CHAR_UTF8(2),
+	/* 0xc2 */ RINKU_CHAR_UTF8(2),
+	/* 0xc3 */ RINKU_CHAR_UTF8(2),
+	/* 0xc4 */ RINKU_CHAR_UTF8(2),
+	/* 0xc5 */ RINKU_CHAR_UTF8(2),
+	/* 0xc6 */ RINKU_CHAR_UTF8(2),
+	/* 0xc7 */ RINKU_CHAR_UTF8(2),
+	/* 0xc8 */ RINKU_CHAR_UTF8(2),
+	/* 0xc9 */ RINKU_CHAR_UTF8(2),
+	/* 0xca */ RINKU_CHAR_UTF8(2),
+	/* 0xcb */ RINKU_CHAR_UTF8(2),
+	/* 0xcc */ RINKU_CHAR_UTF8(2),
+	/* 0xcd */ RINKU_CHAR_UTF8(2),
+	/* 0xce */ RINKU_CHAR_UTF8(2),
+	/* 0xcf */ RINKU_CHAR_UTF8(2),
+	/* 0xd0 */ RINKU_CHAR_UTF8(2),
+	/* 0xd1 */ RINKU_CHAR_UTF8(2),
+	/* 0xd2 */ RINKU_CHAR_UTF8(2),
+	/* 0xd3 */ RINKU_CHAR_UTF8(2),
+	/* 0xd4 */ RINKU_CHAR_UTF8(2),
+	/* 0xd5 */ RINKU_CHAR_UTF8(2),
+	/* 0xd6 */ RINKU_CHAR_UTF8(2),
+	/* 0xd7 */ RINKU_CHAR_UTF8(2),
+	/* 0xd8 */ RINKU_CHAR_UTF8(2),
+	/* 0xd9 */ RINKU_CHAR_UTF8(2),
+	/* 0xda */ RINKU_CHAR_UTF8(2),
+	/* 0xdb */ RINKU_CHAR_UTF8(2),
+	/* 0xdc */ RINKU_CHAR_UTF8(2),
+	/* 0xdd */ RINKU_CHAR_UTF8(2),
+	/* 0xde */ RINKU_CHAR_UTF8(2),
+	/* 0xdf */ RINKU_CHAR_UTF8(2),
+	/* 0xe0 */ RINKU_CHAR_UTF8(3),
+	/* 0xe1 */ RINKU_CHAR_UTF8(3),
+	/* 0xe2 */ RINKU_CHAR_UTF8(3),
+	/* 0xe3 */ RINKU_CHAR_UTF8(3),
+	/* 0xe4 */ RINKU_CHAR_UTF8(3),
+	/* 0xe5 */ RINKU_CHAR_UTF8(3),
+	/* 0xe6 */ RINKU_CHAR_UTF8(3),
+	/* 0xe7 */ RINKU_CHAR_UTF8(3),
+	/* 0xe8 */ RINKU_CHAR_UTF8(3),
+	/* 0xe9 */ RINKU_CHAR_UTF8(3),
+	/* 0xea */ RINKU_CHAR_UTF8(3),
+	/* 0xeb */ RINKU_CHAR_UTF8(3),
+	/* 0xec */ RINKU_CHAR_UTF8(3),
+	/* 0xed */ RINKU_CHAR_UTF8(3),
+	/* 0xee */ RINKU_CHAR_UTF8(3),
+	/* 0xef */ RINKU_CHAR_UTF8(3),
+	/* 0xf0 */ RINKU_CHAR_UTF8(4),
+	/* 0xf1 */ RINKU_CHAR_UTF8(4),
+	/* 0xf2 */ RINKU_CHAR_UTF8(4),
+	/* 0xf3 */ RINKU_CHAR_UTF8(4),
+	/* 0xf4 */ RINKU_CHAR_UTF8(4),
+	/* 0xf5 */ RINKU_CHAR_UTF8(4),
+	/* 0xf6 */ RINKU_CHAR_UTF8(4),
+	/* 0xf7 */ RINKU_CHAR_UTF8(4),
+	/* 0xf8 */ RINKU_CHAR_UTF8(0),
+	/* 0xf9 */ RINKU_CHAR_UTF8(0),
+	/* 0xfa */ RINKU_CHAR_UTF8(0),
+	/* 0xfb */ RINKU_CHAR_UTF8(0),
+	/* 0xfc */ RINKU_CHAR_UTF8(0),
+	/* 0xfd */ RINKU_CHAR_UTF8(0),
+	/* 0xfe */ RINKU_CHAR_UTF8(0),
+	/* 0xff */ RINKU_CHAR_UTF8(0),
+};
+
+#endif
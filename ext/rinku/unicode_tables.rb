@@ -0,0 +1,230 @@
+# Generates unicode_tables.h, the character classes used by utf8.c:
+#
+#   ruby ext/rinku/unicode_tables.rb [--ucd UnicodeData.txt --unicode-version X.Y.Z]
+#
+# With --ucd, the general categories are read from that copy of the
+# Unicode Character Database. Without it, they come from the tables built
+# into Ruby's regexp engine, whose Unicode version is used instead.
+#
+# Each class is a two-level table: the first level maps every block of
+# 256 codepoints to a second level bitmap, and identical bitmaps are
+# shared. Codepoints past the last one in any class are in none.
+#
+# It also writes rinku_char_class, everything the scanners need to know
+# about a single byte, as a combination of the RINKU_CHAR_* flags in
+# utf8.h.
+require 'optparse'
+
+module RinkuUnicode
+  BLOCK = 256
+  OUTPUT = File.expand_path('unicode_tables.h', __dir__)
+
+  # Rinku has always split words on these, but not on VT, NEL or the line
+  # and paragraph separators
+  SPACE_CONTROLS = [0x09, 0x0A, 0x0C, 0x0D].freeze
+
+  module_function
+
+  # Hash of codepoint => two-letter general category, for every assigned
+  # codepoint that isn't a surrogate
+  def read_ucd(path)
+    categories = {}
+    first = nil
+
+    File.foreach(path) do |line|
+      fields = line.split(';')
+      next if fields.size < 3
+
+      cp = fields[0].to_i(16)
+      name = fields[1]
+      gc = fields[2]
+
+      if name.end_with?(', First>')
+        first = cp
+      elsif name.end_with?(', Last>')
+        (first..cp).each { |c| categories[c] = gc }
+      else
+        categories[cp] = gc
+      end
+    end
+
+    categories.reject { |cp, _| (0xD800..0xDFFF).cover?(cp) }
+  end
+
+  # Same, from the regexp engine; only the categories we need
+  def read_ruby
+    categories = {}
+
+    (0..0x10FFFF).each do |cp|
+      next if (0xD800..0xDFFF).cover?(cp)
+
+      ch = cp.chr(Encoding::UTF_8)
+      if ch.match?(/\p{Punctuation}/)
+        categories[cp] = 'P'
+      elsif ch.match?(/\p{Symbol}/)
+        categories[cp] = 'S'
+      elsif ch.match?(/\p{Space_Separator}/)
+        categories[cp] = 'Zs'
+      end
+    end
+
+    categories
+  end
+
+  # Which codepoints are in each class
+  def classes(categories)
+    space = SPACE_CONTROLS.dup
+    punct = []
+
+    categories.each do |cp, gc|
+      space << cp if gc == 'Zs'
+
+      # In ASCII, symbols such as `$` or `<` count as punctuation too
+      if gc.start_with?('P') || (cp < 0x80 && gc.start_with?('S'))
+        punct << cp
+      end
+    end
+
+    { 'SPACE' => space.sort, 'PUNCT' => punct.sort }
+  end
+
+  # Which link a byte may start, as an autolink_action in rinku.c
+  TRIGGERS = { 'w' => 1, 'W' => 1, '@' => 2, ':' => 3, '<' => 4 }.freeze
+
+  # Bytes that are not punctuation inside a hostname
+  HOST_PUNCT = { '-' => nil, '.' => 'RINKU_CHAR_HOST_DOT', '_' => 'RINKU_CHAR_HOST_USCORE' }.freeze
+
+  def utf8_length(byte)
+    case byte
+    when 0x00..0x7F then 1
+    when 0xC0..0xDF then 2
+    when 0xE0..0xEF then 3
+    when 0xF0..0xF7 then 4
+    else 0
+    end
+  end
+
+  # The flags of every byte, as C expressions
+  def char_classes(classes)
+    space = classes['SPACE']
+    punct = classes['PUNCT']
+
+    (0...256).map do |byte|
+      ch = byte.chr
+      flags = []
+
+      if byte < 0x80
+        # the C locale classes, where VT is a space too
+        flags << 'RINKU_CHAR_SPACE' if (0x09..0x0D).cover?(byte) || byte == 0x20
+        flags << 'RINKU_CHAR_PUNCT' if ch.match?(/[[:punct:]]/)
+        flags << 'RINKU_CHAR_DIGIT' if ch.match?(/[0-9]/)
+        flags << 'RINKU_CHAR_ALPHA' if ch.match?(/[A-Za-z]/)
+
+        if HOST_PUNCT.key?(ch)
+          flags << HOST_PUNCT[ch] if HOST_PUNCT[ch]
+        elsif space.include?(byte) || punct.include?(byte)
+          flags << 'RINKU_CHAR_HOST_END'
+        end
+
+        flags << 'RINKU_CHAR_EMAIL' if ch.match?(/[0-9A-Za-z.+\-_%]/)
+        flags << "RINKU_CHAR_TRIGGER(#{TRIGGERS[ch]})" if TRIGGERS[ch]
+      end
+
+      flags << "RINKU_CHAR_UTF8(#{utf8_length(byte)})"
+      flags.join(' | ')
+    end
+  end
+
+  def char_label(byte)
+    if byte > 0x20 && byte < 0x7F
+      format("0x%02x %s", byte, byte.chr)
+    else
+      format("0x%02x", byte)
+    end
+  end
+
+  def bitmap_words(codepoints, block)
+    words = Array.new(BLOCK / 32, 0)
+    codepoints.each do |cp|
+      next unless cp / BLOCK == block
+      offset = cp % BLOCK
+      words[offset / 32] |= 1 << (offset % 32)
+    end
+    words
+  end
+
+  def generate(classes, version)
+    limit = classes.values.flatten.max / BLOCK + 1
+    names = classes.keys
+    by_block = classes.transform_values { |cps| cps.group_by { |cp| cp / BLOCK } }
+
+    blocks = []
+    index = {}
+    stage1 = (0...limit).map do |block|
+      bitmaps = names.map { |name| bitmap_words(by_block[name].fetch(block, []), block) }
+      index[bitmaps] ||= (blocks << bitmaps).size - 1
+    end
+
+    raise "too many distinct blocks" if blocks.size > 256
+
+    out = []
+    out << "/* Generated by unicode_tables.rb; do not edit by hand */"
+    out << "#ifndef RINKU_UNICODE_TABLES_H"
+    out << "#define RINKU_UNICODE_TABLES_H"
+    out << ""
+    out << "#define UNICODE_VERSION \"#{version}\""
+    out << "#define UNICODE_TABLE_LIMIT 0x#{(limit * BLOCK).to_s(16).upcase}"
+    out << ""
+    out << "enum {"
+    names.each { |name| out << "\tUNICODE_#{name}," }
+    out << "\tUNICODE_CLASSES"
+    out << "};"
+    out << ""
+    out << "/* index into unicode_stage2 of each block of #{BLOCK} codepoints */"
+    out << "static const uint8_t unicode_stage1[#{limit}] = {"
+    stage1.each_slice(16) { |row| out << "\t" + row.join(", ") + "," }
+    out << "};"
+    out << ""
+    out << "static const uint32_t unicode_stage2[#{blocks.size}][UNICODE_CLASSES][#{BLOCK / 32}] = {"
+    blocks.each do |bitmaps|
+      out << "\t{"
+      bitmaps.each do |words|
+        out << "\t\t{" + words.map { |w| format("0x%08x", w) }.join(", ") + "},"
+      end
+      out << "\t},"
+    end
+    out << "};"
+    out << ""
+    out << "/* what each byte is to the scanners; see RINKU_CHAR_* in utf8.h */"
+    out << "const uint16_t rinku_char_class[256] = {"
+    char_classes(classes).each_with_index do |flags, byte|
+      out << "\t/* #{char_label(byte)} */ #{flags},"
+    end
+    out << "};"
+    out << ""
+    out << "#endif"
+    out.join("\n") + "\n"
+  end
+
+  def run(argv)
+    options = {}
+    OptionParser.new do |opts|
+      opts.on("--ucd PATH", "UnicodeData.txt to read the categories from") { |path| options[:ucd] = path }
+      opts.on("--unicode-version VERSION", "version of that UnicodeData.txt") { |v| options[:version] = v }
+      opts.on("-o PATH", "where to write the tables (default: #{OUTPUT})") { |path| options[:output] = path }
+    end.parse!(argv)
+
+    if options[:ucd]
+      abort "--unicode-version is required with --ucd" unless options[:version]
+      categories = read_ucd(options[:ucd])
+      version = options[:version]
+    else
+      categories = read_ruby
+      version = RbConfig::CONFIG['UNICODE_VERSION']
+    end
+
+    File.write(options[:output] || OUTPUT, generate(classes(categories), version))
+  end
+end
+
+RinkuUnicode.run(ARGV) if $0 == __FILE__
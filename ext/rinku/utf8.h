@@ -16,21 +16,64 @@
 #ifndef RINKU_UTF8_H
 #define RINKU_UTF8_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-bool rinku_isspace(char c);
-bool rinku_ispunct(char c);
-bool rinku_isdigit(char c);
-bool rinku_isalpha(char c);
-bool rinku_isalnum(char c);
+/* Flags of rinku_char_class, which unicode_tables.rb generates */
+enum {
+	RINKU_CHAR_SPACE = (1 << 0),	/* as in the C locale */
+	RINKU_CHAR_PUNCT = (1 << 1),
+	RINKU_CHAR_DIGIT = (1 << 2),
+	RINKU_CHAR_ALPHA = (1 << 3),
+	RINKU_CHAR_HOST_END = (1 << 4),	/* ASCII that ends a hostname */
+	RINKU_CHAR_HOST_DOT = (1 << 5),
+	RINKU_CHAR_HOST_USCORE = (1 << 6),
+	RINKU_CHAR_EMAIL = (1 << 7),	/* may be in the user part of an address */
+};
+
+/* bits 9-11: length of the UTF-8 sequence a byte starts, or 0 if it
+ * can't start one; bits 12-14: the link it triggers a look for */
+#define RINKU_CHAR_UTF8(len) ((len) << 9)
+#define RINKU_CHAR_UTF8_LEN(cls) (((cls) >> 9) & 0x7)
+#define RINKU_CHAR_TRIGGER(action) ((action) << 12)
+#define RINKU_CHAR_TRIGGER_OF(cls) (((cls) >> 12) & 0x7)
+
+extern const uint16_t rinku_char_class[256];
+
+static inline bool rinku_isspace(char c)
+{
+	return (rinku_char_class[(uint8_t)c] & RINKU_CHAR_SPACE) != 0;
+}
+
+static inline bool rinku_ispunct(char c)
+{
+	return (rinku_char_class[(uint8_t)c] & RINKU_CHAR_PUNCT) != 0;
+}
+
+static inline bool rinku_isdigit(char c)
+{
+	return (rinku_char_class[(uint8_t)c] & RINKU_CHAR_DIGIT) != 0;
+}
+
+static inline bool rinku_isalpha(char c)
+{
+	return (rinku_char_class[(uint8_t)c] & RINKU_CHAR_ALPHA) != 0;
+}
+
+static inline bool rinku_isalnum(char c)
+{
+	return (rinku_char_class[(uint8_t)c] &
+		(RINKU_CHAR_DIGIT | RINKU_CHAR_ALPHA)) != 0;
+}
 
 int32_t utf8proc_rewind(const uint8_t *data, size_t pos);
 int32_t utf8proc_next(const uint8_t *str, size_t *pos);
 int32_t utf8proc_back(const uint8_t *data, size_t *pos);
-size_t utf8proc_find_space(const uint8_t *str, size_t pos, size_t size);
 
-int32_t utf8proc_open_paren_character(int32_t cclose);
+#define UTF8PROC_BRACKET_PAIRS 9
+
+int utf8proc_bracket(int32_t uc);
 bool utf8proc_is_space(int32_t uc);
 bool utf8proc_is_punctuation(int32_t uc);
 
@@ -1,33 +1,86 @@
 require 'rinku'
 
 module RailsRinku
+  # Rails >= 5.1 moved tag_options to the tag builder
+  TAG_BUILDER_OPTIONS = Gem::Version.new(Rails.version) >= Gem::Version.new("5.1")
+
+  # How many sets of options get a compiled Linker; past that, the cache
+  # starts over
+  LINKER_CACHE_SIZE = 256
+
+  # The html attributes of links when none are given
+  NO_HTML = {}.freeze
+
+  @linkers = {}
+  @linkers_lock = Mutex.new
+
+  # The Linker for one set of options, compiled by the block the first
+  # time they are seen
+  def self.linker(key)
+    @linkers[key] || @linkers_lock.synchronize do
+      next @linkers[key] if @linkers.key?(key)
+
+      @linkers.clear if @linkers.size >= LINKER_CACHE_SIZE
+      # the caller may change its options afterwards, down to the
+      # Strings nested in the html attributes
+      @linkers[frozen_copy(key)] = yield
+    end
+  end
+
+  # A copy of a cache key that is frozen all the way down
+  def self.frozen_copy(value)
+    case value
+    when Hash
+      value.each_with_object({}) { |(k, v), copy| copy[frozen_copy(k)] = frozen_copy(v) }.freeze
+    when Array
+      value.map { |part| frozen_copy(part) }.freeze
+    when String
+      value.frozen? ? value : value.dup.freeze
+    else
+      value
+    end
+  end
+
   def rinku_auto_link(text, *args, &block)
     return '' if text.blank?
 
-    options = args.size == 2 ? {} : args.extract_options!
-    unless args.empty?
-      options[:link] = args[0] || :all
-      options[:html] = args[1] || {}
-      options[:skip] = args[2]
+    # auto_link(text, options) or auto_link(text, link, html, skip); the
+    # caller's options are only read
+    options = args.pop if args.size != 2 && args.last.instance_of?(Hash)
+    if !args.empty?
+      link, html, skip = args
+    elsif options
+      link, html, skip = options[:link], options[:html], options[:skip]
     end
-    options.reverse_merge!(:link => :all, :html => {})
-    text = h(text) unless text.html_safe?
 
-    tag_options_method = if Gem::Version.new(Rails.version) >= Gem::Version.new("5.1")
-      # Rails >= 5.1
-      tag_builder.method(:tag_options)
-    else
-      # Rails <= 5.0
-      method(:tag_options)
+    link ||= :all
+    html ||= NO_HTML
+    skip ||= Rinku.skip_tags
+
+    # Unsafe text is escaped by Rinku as it is linked, as h() would
+    text = text.to_s
+    flags = text.html_safe? ? 0 : Rinku::AUTOLINK_ESCAPE_HTML
+
+    linker = RailsRinku.linker([link, html, skip, flags]) do
+      Rinku::Linker.new(
+        mode: link,
+        link_attr: rinku_tag_options(html),
+        skip_tags: skip,
+        flags: flags
+      )
     end
 
-    Rinku.auto_link(
-      text,
-      options[:link],
-      tag_options_method.call(options[:html]),
-      options[:skip],
-      &block
-    ).html_safe
+    linker.auto_link(text, &block).html_safe
+  end
+
+  private
+
+  def rinku_tag_options(html)
+    if TAG_BUILDER_OPTIONS
+      tag_builder.tag_options(html)
+    else
+      tag_options(html)
+    end
   end
 end
 
@@ -1,11 +1,26 @@
 module Rinku
-  VERSION = "2.0.6"
-
-  class << self
-    attr_accessor :skip_tags
-  end
-
-  self.skip_tags = nil
+  VERSION = "2.0.6".freeze
 end
 
 require 'rinku.so'
+
+module Rinku
+  class Stream
+    CHUNK_SIZE = 64 * 1024
+
+    # Autolinks everything that can be read from `input`, writing the
+    # result to `output` without loading the whole text in memory.
+    # Takes the same options as `Rinku::Stream.new`.
+    def self.link(input, output, *args, &block)
+      stream = new(output, *args, &block)
+      encoding = input.external_encoding || Encoding.default_external
+      chunk = String.new
+
+      while input.read(CHUNK_SIZE, chunk)
+        stream.write(chunk.force_encoding(encoding))
+      end
+
+      stream.finish
+    end
+  end
+end
@@ -4,6 +4,7 @@ $LOAD_PATH.unshift File.expand_path('../../lib', __FILE__)
 require 'minitest/autorun'
 require 'cgi'
 require 'uri'
+require 'stringio'
 require 'rinku'
 
 class RinkuAutoLinkTest < Minitest::Test
@@ -39,6 +40,102 @@ class RinkuAutoLinkTest < Minitest::Test
     refute_equal Rinku.auto_link(url), url
   end
 
+  def test_global_skip_tags_snapshot
+    tags = ['pa']
+    Rinku.skip_tags = tags
+    tags << 'pre'
+
+    assert_equal ['pa'], Rinku.skip_tags
+    assert Rinku.skip_tags.frozen?
+    assert_equal '<pre><a href="http://www.pokemon.com">http://www.pokemon.com</a></pre>',
+      Rinku.auto_link('<pre>http://www.pokemon.com</pre>')
+    assert_raises(TypeError) { Rinku.skip_tags = [:pre] }
+  ensure
+    Rinku.skip_tags = nil
+  end
+
+  def test_skip_tags_of_failed_calls
+    tags = %w(pa pb pc pd)
+
+    100.times do
+      assert_raises(ArgumentError) { Rinku.auto_link("www.a.com", :all, nil, tags, timeout: -1) }
+      assert_raises(ArgumentError) { Rinku.auto_link_many(["www.a.com"], :all, nil, tags, max_links: 0) }
+      assert_raises(ArgumentError) { Rinku::Linker.new(skip_tags: tags, max_bytes: 0) }
+      assert_raises(RuntimeError) { Rinku.auto_link("www.a.com", :all, nil, tags) { raise "boom" } }
+      assert_raises(ArgumentError) { Rinku.auto_link("www.a.com", :all, nil, ["pa", "p\0b"]) }
+    end
+
+    assert_equal '<pa>www.a.com</pa>', Rinku.auto_link('<pa>www.a.com</pa>', :all, nil, tags) { "x" }
+  end
+
+  def test_ractors
+    skip "no Ractors" unless defined?(Ractor)
+
+    text = "<code>www.code.com</code> www.rinku.com me@rinku.com " * 20
+    linker = Rinku::Linker.new(link_attr: 'rel="nofollow"', domains: { "rinku.com" => true })
+    assert Ractor.shareable?(linker)
+
+    expected = [Rinku.auto_link(text), linker.auto_link(text)]
+    verbose, Warning[:experimental] = Warning[:experimental], false
+    ractors = 2.times.map do
+      Ractor.new(linker, text) { |l, t| 100.times.map { [Rinku.auto_link(t), l.auto_link(t)] }.uniq }
+    end
+
+    ractors.each { |r| assert_equal [expected], r.take }
+  ensure
+    Warning[:experimental] = verbose unless verbose.nil?
+  end
+
+  def test_ractors_cant_change_settings
+    skip "no Ractors" unless defined?(Ractor)
+
+    verbose, Warning[:experimental] = Warning[:experimental], false
+    errors = Ractor.new do
+      [
+        -> { Rinku.nogvl_threshold = 1 },
+        -> { Rinku.parallel_threshold = nil },
+        -> { Rinku.collect_stats = true },
+      ].map do |set|
+        begin
+          set.call
+          nil
+        rescue Ractor::IsolationError => e
+          e.message
+        end
+      end + [Rinku.nogvl_threshold, Rinku.collect_stats]
+    end.take
+
+    assert_match(/nogvl_threshold/, errors[0])
+    assert_match(/parallel_threshold/, errors[1])
+    assert_match(/collect_stats/, errors[2])
+    assert_equal [64 * 1024, false], errors[3..]
+    assert_equal 64 * 1024, Rinku.nogvl_threshold
+    refute Rinku.collect_stats
+  ensure
+    Warning[:experimental] = verbose unless verbose.nil?
+  end
+
+  def test_ractors_set_global_skip_tags
+    skip "no Ractors" unless defined?(Ractor)
+
+    verbose, Warning[:experimental] = Warning[:experimental], false
+    ractors = %w[pa pb].map do |tag|
+      Ractor.new(tag) do |t|
+        200.times.map do
+          Rinku.skip_tags = [t]
+          tags = Rinku.skip_tags
+          [Ractor.shareable?(tags), tags.size, Rinku.auto_link("<#{t}>www.a.com</#{t}>").size]
+        end.uniq
+      end
+    end
+
+    ractors.each { |r| r.take.each { |shareable, size, _| assert shareable; assert_equal 1, size } }
+    assert Ractor.shareable?(Rinku.skip_tags)
+  ensure
+    Warning[:experimental] = verbose unless verbose.nil?
+    Rinku.skip_tags = nil
+  end
+
   def test_auto_link_with_single_trailing_punctuation_and_space
     url = "http://www.youtube.com"
     url_result = generate_result(url)
@@ -369,6 +466,19 @@ This is just a test. <a href="http://www.pokemon.com">http://www.pokemon.com</a>
     )
   end
 
+  def test_punctuation_follows_unicode
+    # U+2E43 is newer than the hand-written tables; U+166D is a symbol since Unicode 12
+    assert_linked %{\u2E43<a href="http://www.example.com">www.example.com</a>},
+      "\u2E43www.example.com"
+    assert_linked "\u166Dwww.example.com", "\u166Dwww.example.com"
+  end
+
+  def test_non_ascii_hosts
+    assert_linked generate_result("www.ex\u00E4mple.com/\u00E4"), "www.ex\u00E4mple.com/\u00E4"
+    assert_linked generate_result("www.\u4F8B\u3048.\u30C6\u30B9\u30C8/x"), "www.\u4F8B\u3048.\u30C6\u30B9\u30C8/x"
+    assert_linked "www.ex_\u00E4mple.com", "www.ex_\u00E4mple.com"
+  end
+
   def test_www_is_case_insensitive
     url = "www.reddit.com"
     assert_linked generate_result(url), url
@@ -397,8 +507,10 @@ This is just a test. <a href="http://www.pokemon.com">http://www.pokemon.com</a>
 
     assert_linked "&lt;<a href=\"http://www.google.com\">http://www.google.com</a>&gt;)", "&lt;http://www.google.com&gt;)"
 
-    # this produces invalid output, but limits how much work we will do
-    assert_linked "&lt;<a href=\"http://www.google.com&gt;\">http://www.google.com&gt;</a>)&lt;)&lt;)&lt;)&lt;)&lt;)&lt;)", "&lt;http://www.google.com&gt;)&lt;)&lt;)&lt;)&lt;)&lt;)&lt;)"
+    # the whole tail is trimmed, however many times it has to be
+    assert_linked "&lt;<a href=\"http://www.google.com\">http://www.google.com</a>&gt;)&lt;)&lt;)&lt;)&lt;)&lt;)&lt;)", "&lt;http://www.google.com&gt;)&lt;)&lt;)&lt;)&lt;)&lt;)&lt;)"
+    assert_linked "(<a href=\"http://example.com/a_(b)\">http://example.com/a_(b)</a>]))}.\".)]", "(http://example.com/a_(b)]))}.\".)]"
+    assert_linked "<a href=\"http://example.com/\u3010a\u3011\">http://example.com/\u3010a\u3011</a>\u3011\uFF09", "http://example.com/\u3010a\u3011\u3011\uFF09"
 
     url = "http://pokemon.com/bulbasaur"
     assert_linked "URL is #{generate_result(url)}.", "URL is #{url}."
@@ -442,4 +554,672 @@ This is just a test. <a href="http://www.pokemon.com">http://www.pokemon.com</a>
   def test_regression_84
     assert_linked "<a href=\"https://www.keepright.atの情報をもとにエラー修正\">https://www.keepright.atの情報をもとにエラー修正</a>", "https://www.keepright.atの情報をもとにエラー修正"
   end
+
+  def test_links_at_every_offset_of_long_text
+    url = "http://example.com"
+    (0..130).each do |pad|
+      text = ("x" * pad) + " #{url} " + ("y" * pad)
+      expected = ("x" * pad) + " #{generate_result(url)} " + ("y" * pad)
+      assert_linked expected, text
+    end
+  end
+
+  def test_auto_link_many
+    texts = [
+      "Go to http://www.pokemon.com",
+      "nothing to see here",
+      "mail david@loudthinking.com or visit www.example.com",
+      "",
+    ] * 20
+
+    assert_equal texts.map { |t| Rinku.auto_link(t) }, Rinku.auto_link_many(texts)
+    assert_equal texts.map { |t| Rinku.auto_link(t, :urls, 'rel="nofollow"', ["a"]) },
+      Rinku.auto_link_many(texts, :urls, 'rel="nofollow"', ["a"])
+    assert_equal [], Rinku.auto_link_many([])
+  end
+
+  def test_auto_link_many_after_fork
+    skip "no fork" unless Process.respond_to?(:fork)
+
+    texts = ["Go to http://www.pokemon.com"] * 16
+    expected = texts.map { |t| Rinku.auto_link(t) }
+    assert_equal expected, Rinku.auto_link_many(texts)
+
+    reader, writer = IO.pipe
+    pid = fork do
+      reader.close
+      writer.write(Marshal.dump(Rinku.auto_link_many(texts)))
+      writer.close
+      exit!(0)
+    end
+    writer.close
+    result = Marshal.load(reader.read)
+    Process.wait(pid)
+
+    assert_equal expected, result
+    assert_equal expected, Rinku.auto_link_many(texts)
+  end
+
+  def test_auto_link_many_with_block
+    texts = ["http://www.pokemon.com", "and www.pokemon.com"]
+    result = Rinku.auto_link_many(texts) { |url| url.upcase }
+    assert_equal texts.map { |t| Rinku.auto_link(t) { |url| url.upcase } }, result
+  end
+
+  def test_auto_link_many_validates_all_inputs
+    assert_raises ArgumentError do
+      Rinku.auto_link_many(["http://www.pokemon.com", "invalid \xA0 utf8"])
+    end
+
+    assert_raises TypeError do
+      Rinku.auto_link_many(["http://www.pokemon.com", nil])
+    end
+  end
+
+  def test_nogvl_threshold
+    default = Rinku.nogvl_threshold
+    text = "Go to http://www.pokemon.com or mail david@loudthinking.com. " * 200
+    expected = Rinku.auto_link(text, :all, 'rel="nofollow"')
+
+    Rinku.nogvl_threshold = 1
+    assert_equal 1, Rinku.nogvl_threshold
+    assert_equal expected, Rinku.auto_link(text, :all, 'rel="nofollow"')
+    assert_equal "plain", Rinku.auto_link("plain")
+
+    Rinku.nogvl_threshold = nil
+    assert_nil Rinku.nogvl_threshold
+    assert_equal expected, Rinku.auto_link(text, :all, 'rel="nofollow"')
+  ensure
+    Rinku.nogvl_threshold = default
+  end
+
+  def test_parallel_threshold
+    default = Rinku.parallel_threshold
+    text = 20_000.times.map do |i|
+      ["Go to http://www.pokemon.com/#{i}", "<pre>www.less.es\n\n</pre>",
+       "<a href=\"www.a.com\">www.b.com</a>", "mail david@loudthinking.com.\n",
+       "(「http://example.com/」)", "<!-- www.c.com -->", "x" * (i % 97)].sample(random: Random.new(i))
+    end.join(" ")
+    linker = Rinku::Linker.new(template: '<a href="{href}">{text:12}</a>')
+
+    Rinku.parallel_threshold = nil
+    assert_nil Rinku.parallel_threshold
+    expected = [Rinku.auto_link(text), Rinku.auto_link(text, :urls, nil, nil, Rinku::AUTOLINK_ESCAPE_HTML),
+      linker.auto_link(text), Rinku.auto_link_many([text, "www.a.com"])]
+
+    Rinku.parallel_threshold = 1
+    assert_equal 1, Rinku.parallel_threshold
+    assert_equal expected, [Rinku.auto_link(text), Rinku.auto_link(text, :urls, nil, nil, Rinku::AUTOLINK_ESCAPE_HTML),
+      linker.auto_link(text), Rinku.auto_link_many([text, "www.a.com"])]
+
+    plain = "no links here " * 50_000
+    assert_same plain, Rinku.auto_link(plain)
+  ensure
+    Rinku.parallel_threshold = default
+  end
+
+  def test_nogvl_autolink_can_be_interrupted
+    text = "http://www.pokemon.com " * 500_000
+    thread = Thread.new { Rinku.auto_link(text) }
+    thread.report_on_exception = false
+    sleep 0.01
+    thread.raise(RuntimeError, "stop")
+
+    result = begin
+      thread.value
+    rescue RuntimeError
+      :interrupted
+    end
+    assert result == :interrupted || result.start_with?("<a href=")
+  end
+
+  def stream_auto_link(chunks, *args, &block)
+    output = StringIO.new(String.new)
+    stream = Rinku::Stream.new(output, *args, &block)
+    chunks.each { |chunk| stream << chunk }
+    stream.finish
+    output.string.force_encoding(Encoding::UTF_8)
+  end
+
+  def test_stream_matches_auto_link
+    text = "Go to http://www.pokemon.com/Pikachu_(Electric), <pre>www.less.es\n</pre> " \
+      "or mail david@loudthinking.com (「http://example.com/」) <a href=\"x\">www.a.com</a>"
+    bytes = text.b
+
+    [1, 2, 5, 13, bytes.size].each do |size|
+      chunks = bytes.scan(/.{1,#{size}}/m).map { |c| c.force_encoding(Encoding::UTF_8) }
+      assert_equal Rinku.auto_link(text), stream_auto_link(chunks)
+      assert_equal Rinku.auto_link(text, :urls, 'rel="nofollow"', ["a"]),
+        stream_auto_link(chunks, :urls, 'rel="nofollow"', ["a"])
+    end
+  end
+
+  def test_self_closed_skip_tags
+    link = %(<a href="http://www.a.com">www.a.com</a>)
+
+    assert_equal "a <pre/> #{link} b", Rinku.auto_link("a <pre/> www.a.com b")
+    assert_equal "<br/> #{link}", Rinku.auto_link("<br/> www.a.com")
+    assert_equal %(<pre class="x"/> #{link}), Rinku.auto_link(%(<pre class="x"/> www.a.com))
+    assert_equal %(<code a=b/> #{link}), Rinku.auto_link(%(<code a=b/> www.a.com))
+
+    # not self-closed: the slash isn't the last byte of the tag
+    text = %(<pre / > www.a.com</pre> <pre a="/"> www.a.com</pre>)
+    assert_equal text, Rinku.auto_link(text)
+
+    text = "a <pre/> www.a.com <pre>www.b.com</pre> www.c.com"
+    assert_equal Rinku.auto_link(text), stream_auto_link(text.chars.each_slice(3).map(&:join))
+  end
+
+  def test_stream_holds_back_open_skip_tags
+    output = StringIO.new(String.new)
+    stream = Rinku::Stream.new(output)
+
+    stream << "<pre>\n"
+    stream << "http://www.pokemon.com\n" * 100
+    stream << "</pre> http://www.pokemon.com"
+    stream.finish
+
+    assert_equal "<pre>\n#{"http://www.pokemon.com\n" * 100}</pre> #{generate_result("http://www.pokemon.com")}",
+      output.string
+  end
+
+  def test_stream_link_from_io
+    text = "Visit www.pokemon.com or write to david@loudthinking.com\n" * 5000
+    output = Rinku::Stream.link(StringIO.new(text), StringIO.new(String.new))
+    assert_equal Rinku.auto_link(text), output.string
+  end
+
+  def test_stream_with_block
+    assert_equal Rinku.auto_link("x http://www.pokemon.com y") { |url| url.upcase },
+      stream_auto_link(["x http://www.pok", "emon.com y"]) { |url| url.upcase }
+  end
+
+  def test_stream_rejects_writes_from_its_block
+    output = StringIO.new(String.new)
+    stream = Rinku::Stream.new(output) do |url|
+      stream << "www.inner.com "
+      url
+    end
+
+    assert_raises(RuntimeError) { stream << "x http://www.pokemon.com y" }
+
+    stream = Rinku::Stream.new(output) { |url| stream.finish; url }
+    assert_raises(RuntimeError) { stream << "x http://www.pokemon.com y" }
+
+    output.truncate(0)
+    stream = Rinku::Stream.new(output) { |url| url.upcase }
+    stream << "x http://www.pokemon.com y"
+    stream.finish
+    assert_equal Rinku.auto_link("x http://www.pokemon.com y") { |url| url.upcase }, output.string
+  end
+
+  def test_exact_size_flag
+    text = %(Go to http://www.pokemon.com/"quoted" or mail david@loudthinking.com. ) * 50
+    flags = Rinku::AUTOLINK_EXACT_SIZE
+
+    assert_equal Rinku.auto_link(text), Rinku.auto_link(text, nil, nil, nil, flags)
+    assert_equal Rinku.auto_link(text, :all, ' target="_blank"'),
+      Rinku.auto_link(text, :all, ' target="_blank"', nil, flags)
+    assert_equal Rinku.auto_link(text) { |l| l.upcase },
+      Rinku.auto_link(text, nil, nil, nil, flags) { |l| l.upcase }
+    assert_equal "no links", Rinku.auto_link("no links", nil, nil, nil, flags)
+  end
+
+  def test_escape_html_flag
+    flags = Rinku::AUTOLINK_ESCAPE_HTML
+    text = %(<b>"Tom & Jerry's"</b> at http://www.pokemon.com/?a=1&b=<2> or <david@loudthinking.com> ) * 20
+
+    assert_equal Rinku.auto_link(CGI.escapeHTML(text)), Rinku.auto_link(text, nil, nil, nil, flags)
+    assert_equal Rinku.auto_link(CGI.escapeHTML(text)) { |l| l.upcase },
+      Rinku.auto_link(text, nil, nil, nil, flags | Rinku::AUTOLINK_EXACT_SIZE) { |l| l.upcase }
+    assert_equal "1 &lt; 2", Rinku.auto_link("1 < 2", nil, nil, nil, flags)
+    assert_equal "1 &lt; 2", Rinku.auto_link_into(String.new, "1 < 2", nil, nil, nil, flags)
+    assert_equal ["a &amp; b", "c"], Rinku.auto_link_many(["a & b", "c"], nil, nil, nil, flags)
+    assert_equal "<a>", Rinku.auto_link("<a>")
+    assert_equal Rinku.auto_link(CGI.escapeHTML(text)),
+      stream_auto_link(text.scan(/.{1,7}/m), nil, nil, nil, flags)
+
+    assert_raises ArgumentError do
+      Rinku.auto_link(text, nil, nil, nil, flags | Rinku::AUTOLINK_BATCH_CALLBACK) { |links| links }
+    end
+  end
+
+  def test_auto_link_into
+    url = "http://www.rinku.com"
+    out = "<p>"
+    assert_same out, Rinku.auto_link_into(out, "Go to #{url}")
+    assert_same out, Rinku.auto_link_into(out, " and nowhere else</p>")
+    assert_equal "<p>Go to #{generate_result(url)} and nowhere else</p>", out
+
+    long = "Go to #{url} " * 10_000
+    assert_equal Rinku.auto_link(long), Rinku.auto_link_into("", long)
+    assert_equal Rinku.auto_link(long) { |l| l.upcase },
+      Rinku.auto_link_into("", long) { |l| l.upcase }
+
+    out = "Go to #{url} "
+    Rinku.auto_link_into(out, out)
+    assert_equal "Go to #{url} Go to #{generate_result(url)} ", out
+
+    assert_raises(FrozenError) { Rinku.auto_link_into("".freeze, url) }
+    assert_raises(TypeError) { Rinku.auto_link_into(nil, url) }
+    assert_raises(TypeError) { Rinku.auto_link_into(Object.new, url) }
+  end
+
+  class EscapingBuffer
+    attr_reader :parts
+
+    def initialize
+      @parts = []
+    end
+
+    def <<(value)
+      @parts << value.to_s.gsub("<", "&lt;")
+      self
+    end
+
+    def safe_concat(value)
+      @parts << value
+      self
+    end
+  end
+
+  def test_auto_link_into_output_buffer
+    url = "http://www.rinku.com"
+
+    out = EscapingBuffer.new
+    assert_same out, Rinku.auto_link_into(out, "Go to #{url}")
+    assert_same out, Rinku.auto_link_into(out, " nowhere") { |l| l.upcase }
+    assert_equal ["Go to #{generate_result(url)}", " nowhere"], out.parts
+
+    out = []
+    Rinku.auto_link_into(out, "Go to #{url}") { |l| l.upcase }
+    assert_equal [Rinku.auto_link("Go to #{url}") { |l| l.upcase }], out
+  end
+
+  def test_auto_link_into_with_block_changing_out
+    url = "http://www.rinku.com"
+    text = "Go to #{url} or #{url}/x"
+
+    out = String.new("<p>")
+    Rinku.auto_link_into(out, text) { |u| out.replace("x" * 4096); out.clear; u }
+    assert_equal Rinku.auto_link(text), out
+
+    out = String.new("<p>")
+    Rinku.auto_link_into(out, text) { |u| out << "!"; u }
+    assert_equal "<p>!!" + Rinku.auto_link(text), out
+
+    text = String.new(text)
+    out = String.new
+    Rinku.auto_link_into(out, text) { |u| text.replace("y" * 4096); u }
+    assert_equal Rinku.auto_link("Go to #{url} or #{url}/x"), out
+  end
+
+  def test_auto_link_bang
+    url = "http://www.rinku.com"
+    text = "Go to #{url}"
+    assert_same text, Rinku.auto_link!(text)
+    assert_equal "Go to #{generate_result(url)}", text
+
+    text = "no links here"
+    assert_nil Rinku.auto_link!(text)
+    assert_equal "no links here", text
+
+    assert_raises(FrozenError) { Rinku.auto_link!(url.dup.freeze) }
+  end
+
+  def test_each_link
+    text = "Go to http://www.rinku.com, www.github.com or mail <b>david@loudthinking.com</b> <a href='x'>http://skip.me</a>"
+    links = []
+    Rinku.each_link(text) { |start, stop, kind| links << [text.byteslice(start...stop), kind] }
+
+    assert_equal [["http://www.rinku.com", :url], ["www.github.com", :www],
+      ["david@loudthinking.com", :email]], links
+
+    expected = []
+    Rinku.auto_link(text) { |link| expected << link; link }
+    assert_equal expected, links.map(&:first)
+
+    assert_equal [:email], Rinku.each_link(text, :email_addresses).map { |*, kind| kind }
+    assert_equal %w(http://www.rinku.com www.github.com http://skip.me),
+      Rinku.each_link(text, :all, ["b"]).map { |start, stop| text.byteslice(start...stop) }
+    assert_equal [], Rinku.each_link("no links here").to_a
+  end
+
+  def test_each_link_is_lazy
+    text = "http://www.rinku.com " * 1000
+    seen = 0
+    Rinku.each_link(text) { seen += 1; break if seen == 2 }
+    assert_equal 2, seen
+
+    enum = Rinku.each_link("caf\u00e9 http://x.com")
+    assert_equal [6, 18, :url], enum.next
+    assert_raises(StopIteration) { enum.next }
+  end
+
+  def test_link_offsets
+    text = "Go to http://www.rinku.com or www.github.com, mail david@loudthinking.com"
+    packed = Rinku.link_offsets(text)
+
+    assert_equal Encoding::BINARY, packed.encoding
+    assert_equal 3 * 12, packed.bytesize
+    assert_equal Rinku.each_link(text).map { |s, e, k| [s, e, {www: 1, email: 2, url: 3}[k]] },
+      packed.unpack("V*").each_slice(3).to_a
+    assert_equal "", Rinku.link_offsets("no links here")
+  end
+
+  def test_memoized_block
+    text = "http://a.com http://b.com http://a.com www.a.com http://a.com"
+    calls = []
+    result = Rinku.auto_link(text, :all, nil, nil, Rinku::AUTOLINK_MEMOIZE) do |link|
+      calls << link
+      link.upcase
+    end
+
+    assert_equal %w(http://a.com http://b.com www.a.com), calls
+    assert_equal Rinku.auto_link(text) { |link| link.upcase }, result
+  end
+
+  def test_batch_callback
+    text = "http://a.com http://b.com http://a.com mail me@a.com"
+    calls = []
+    result = Rinku.auto_link(text, :all, nil, nil, Rinku::AUTOLINK_BATCH_CALLBACK) do |links|
+      calls << links
+      links.map(&:upcase)
+    end
+
+    assert_equal [%w(http://a.com http://b.com me@a.com)], calls
+    assert_equal Rinku.auto_link(text) { |link| link.upcase }, result
+
+    result = Rinku.auto_link(text, :all, nil, nil, Rinku::AUTOLINK_BATCH_CALLBACK) do |links|
+      { "http://a.com" => "A" }
+    end
+    assert_equal Rinku.auto_link(text) { |link| link == "http://a.com" ? "A" : link }, result
+
+    called = false
+    Rinku.auto_link("no links", :all, nil, nil, Rinku::AUTOLINK_BATCH_CALLBACK) { called = true }
+    refute called
+
+    assert_raises(ArgumentError) do
+      Rinku.auto_link(text, :all, nil, nil, Rinku::AUTOLINK_BATCH_CALLBACK) { |links| [] }
+    end
+    assert_raises(TypeError) do
+      Rinku.auto_link(text, :all, nil, nil, Rinku::AUTOLINK_BATCH_CALLBACK) { |links| nil }
+    end
+  end
+
+  def test_quoted_gt_in_attributes
+    url = "http://www.rinku.com"
+    assert_linked %(<img alt="a > b" src="x.png"> #{generate_result(url)}), %(<img alt="a > b" src="x.png"> #{url})
+    assert_linked %(<img alt='#{url}>'> #{generate_result(url)}), %(<img alt='#{url}>'> #{url})
+    assert_linked %(<a title="x > y" href="#{url}">#{url}</a> #{generate_result(url)}),
+      %(<a title="x > y" href="#{url}">#{url}</a> #{url})
+  end
+
+  def test_comments_and_cdata_are_skipped
+    url = "http://www.rinku.com"
+    assert_linked %(<!-- #{url} --> #{generate_result(url)}), %(<!-- #{url} --> #{url})
+    assert_linked %(<!-- a > #{url} --> #{generate_result(url)}), %(<!-- a > #{url} --> #{url})
+    assert_linked %(<!----> #{generate_result(url)}), %(<!----> #{url})
+    assert_linked %(<![CDATA[ a > #{url} ]]> #{generate_result(url)}), %(<![CDATA[ a > #{url} ]]> #{url})
+    assert_linked %(<!DOCTYPE html> #{generate_result(url)}), %(<!DOCTYPE html> #{url})
+  end
+
+  def test_lone_less_than_is_text
+    url = "http://www.rinku.com"
+    assert_linked "1 < 2 and #{generate_result(url)}", "1 < 2 and #{url}"
+    assert_linked "I <3 #{generate_result(url)}", "I <3 #{url}"
+  end
+
+  def test_many_skip_tags
+    url = "http://www.rinku.com"
+    tags = (1..300).map { |i| "tag#{i}" }
+    text = %(<tag250>#{url}</tag250> <tag7 class="x">#{url}</tag7> #{url})
+
+    assert_equal %(<tag250>#{url}</tag250> <tag7 class="x">#{url}</tag7> #{generate_result(url)}),
+      Rinku.auto_link(text, :all, nil, tags)
+    assert_equal %(<tag250>#{url}</tag250> <tag7 class="x">#{url}</tag7> #{generate_result(url)}),
+      Rinku.auto_link(text, :all, nil, tags.first(20) + ["tag250"])
+  end
+
+  def test_linker
+    text = %(Go to http://www.rinku.com, mail me@rinku.com or see <code>http://no.com</code> <div>www.github.com</div>)
+
+    linker = Rinku::Linker.new
+    assert linker.frozen?
+    assert_equal Rinku.auto_link(text), linker.auto_link(text)
+    assert_equal "no links", linker.auto_link("no links")
+
+    linker = Rinku::Linker.new(mode: :urls, link_attr: '  target="_blank"', skip_tags: ["div"], flags: 1)
+    assert_equal Rinku.auto_link(text, :urls, 'target="_blank"', ["div"], 1), linker.auto_link(text)
+    assert_equal Rinku.auto_link(text, :urls, 'target="_blank"', ["div"], 1) { |l| l.upcase },
+      linker.auto_link(text) { |l| l.upcase }
+
+    assert_equal [text, "x"].map { |t| linker.auto_link(t) }, linker.auto_link_many([text, "x"])
+    long = text * 5000
+    assert_equal Rinku.auto_link(long, :urls, 'target="_blank"', ["div"], 1), linker.auto_link(long)
+  end
+
+  def test_linker_template
+    text = %(Go to www.example.com/a/long/path?x=1&amp;y=2 or mail me@rinku.com.)
+    linker = Rinku::Linker.new(
+      template: '<a href="{href}" rel="nofollow" data-kind="{kind}">{text:16}</a>',
+      email_template: '<a href="{href}" class="email">{text}</a>{{}}')
+
+    assert_equal %(Go to <a href="http://www.example.com/a/long/path?x=1&amp;y=2" rel="nofollow" data-kind="www">) +
+      %(www.exam&hellip;x=1&amp;y=2</a> or mail <a href="mailto:me@rinku.com" class="email">me@rinku.com</a>{}.),
+      linker.auto_link(text)
+
+    template = '<a href="{href}">{text:5}</a>'
+    exact = Rinku::Linker.new(template: template, flags: Rinku::AUTOLINK_EXACT_SIZE)
+    assert_equal Rinku::Linker.new(template: template).auto_link(text * 20), exact.auto_link(text * 20)
+
+    # without a template of its own, an email gets the same one
+    assert_equal Rinku.auto_link(text), Rinku::Linker.new(template: '<a href="{href}">{text}</a>').auto_link(text)
+    assert_equal %(Go to <b>WWW.EXAMPLE.COM/A/LONG/PATH?X=1&AMP;Y=2</b> or mail <b>ME@RINKU.COM</b>.),
+      Rinku::Linker.new(template: '<b>{text:3}</b>').auto_link(text) { |l| l.upcase }
+
+    ["{link}", "{text:0}", "{text:", "<a>{href</a>"].each do |template|
+      assert_raises(ArgumentError) { Rinku::Linker.new(template: template) }
+    end
+    assert_raises(ArgumentError) { Rinku::Linker.new(template: "{text}", link_attr: 'rel="x"') }
+  end
+
+  def test_linker_domains
+    text = %(See http://docs.Example.com:8080/x, https://Spam.test/www.inner.com, www.example.org and a@mail.spam.test.)
+    linker = Rinku::Linker.new(link_attr: 'rel="nofollow ugc"', domains: {
+      "example.com" => ' class="internal"',
+      "*.spam.test" => false,
+      "mail.spam.test" => true,
+    })
+
+    assert_equal %(See <a href="http://docs.Example.com:8080/x" class="internal">http://docs.Example.com:8080/x</a>, ) +
+      %(https://Spam.test/www.inner.com, <a href="http://www.example.org" rel="nofollow ugc">www.example.org</a> ) +
+      %(and <a href="mailto:a@mail.spam.test" rel="nofollow ugc">a@mail.spam.test</a>.),
+      linker.auto_link(text)
+
+    exact = Rinku::Linker.new(link_attr: 'rel="nofollow ugc"', flags: Rinku::AUTOLINK_EXACT_SIZE,
+      domains: { "example.com" => 'class="internal"', "spam.test" => false, "mail.spam.test" => true })
+    assert_equal linker.auto_link(text * 20), exact.auto_link(text * 20)
+
+    # an allowlist: nothing else is linked, and skipped links don't count against max_links
+    allow = Rinku::Linker.new(max_links: 1, domains: { "*" => false, "example.org" => true })
+    assert_equal %(See http://docs.Example.com:8080/x, https://Spam.test/www.inner.com, ) +
+      %(<a href="http://www.example.org">www.example.org</a> and a@mail.spam.test.), allow.auto_link(text)
+
+    assert_raises(ArgumentError) { Rinku::Linker.new(domains: { "a..b" => true }) }
+    assert_raises(ArgumentError) { Rinku::Linker.new(domains: { "example.com/" => true }) }
+    assert_raises(TypeError) { Rinku::Linker.new(domains: { "example.com" => 1 }) }
+    assert_raises(ArgumentError) { Rinku::Linker.new(template: "{text}", domains: { "example.com" => 'rel="x"' }) }
+  end
+
+  def test_calls_reuse_thread_context
+    text = %(<pre>www.pre.com</pre> <div>www.div.com</div> http://www.rinku.com)
+    pre = Rinku.auto_link(text, :all, nil, ["pre"])
+    div = Rinku.auto_link(text, :all, nil, ["div"])
+
+    # a call made from the block must not disturb the one that made it
+    nested = Rinku.auto_link(text, :all, nil, ["pre"]) do |link|
+      assert_equal div, Rinku.auto_link(text, :all, nil, ["div"])
+      link
+    end
+    assert_equal pre, nested
+
+    big = "http://www.rinku.com " * 3000
+    assert_equal (generate_result("http://www.rinku.com") + " ") * 3000, Rinku.auto_link(big)
+    assert_equal pre, Rinku.auto_link(text, :all, nil, ["pre"])
+
+    threads = 4.times.map do |i|
+      Thread.new { 200.times.all? { Rinku.auto_link(text, :all, nil, i.even? ? ["pre"] : ["div"]) == (i.even? ? pre : div) } }
+    end
+    assert threads.map(&:value).all?
+  end
+
+  def test_linker_options
+    assert_raises(TypeError) { Rinku::Linker.new(mode: :everything) }
+    assert_raises(ArgumentError) { Rinku::Linker.new(colour: :blue) }
+    assert_raises(ArgumentError) { Rinku::Linker.allocate.auto_link("x") }
+
+    tags = ["b"]
+    linker = Rinku::Linker.new(skip_tags: tags)
+    tags[0] = "i"
+    assert_equal "<b>http://x.com</b>", linker.auto_link("<b>http://x.com</b>")
+    GC.start
+    GC.compact if GC.respond_to?(:compact)
+    assert_equal "<b>http://x.com</b>", linker.auto_link("<b>http://x.com</b>")
+  end
+
+  def test_adversarial_inputs
+    assert_equal "a@<a href=\"mailto:b.com@c.com\">b.com@c.com</a> <a href=\"mailto:x@y.com\">x@y.com</a>",
+      Rinku.auto_link("a@b.com@c.com x@y.com")
+    assert_equal "<a href=\"http://www.www.www.example.com\">www.www.www.example.com</a> www.www.a_b.com",
+      Rinku.auto_link("www.www.www.example.com www.www.a_b.com")
+    assert_equal "see <a href=\"http://www.example.com\">www.example.com</a><,<a href=\"http://www.example.org\">www.example.org</a>",
+      Rinku.auto_link("see www.example.com<,www.example.org")
+
+    # each of these used to walk the rest of the text once per trigger
+    ["a@" * 50_000, "www." * 50_000 + "a_b.c_d", "a://a.b/" * 25_000].each do |text|
+      assert_equal text, Rinku.auto_link(text)
+    end
+  end
+
+  def test_stats
+    Rinku.collect_stats = true
+    Rinku.reset_stats
+
+    text = "see http://a.com, www.b.org and x://y <a href=\"x\">http://c.com</a> me@x.com"
+    Rinku.auto_link(text)
+    stats = Rinku.last_stats
+    assert_equal 1, stats[:calls]
+    assert_equal text.bytesize, stats[:bytes_scanned]
+    assert_equal 1, stats[:markup]
+    assert_equal '<a href="x">http://c.com</a>'.bytesize, stats[:markup_bytes]
+    assert_equal({ www: 1, email: 1, url: 2 }, stats[:triggers])
+    assert_equal({ www: 1, email: 1, url: 1 }, stats[:links])
+    assert_equal({ www: 0, email: 0, url: 0 }, stats[:parse_ns])
+    assert_equal Rinku.auto_link(text).bytesize, stats[:output_bytes]
+
+    Rinku.auto_link_many(["http://a.com", "nothing"])
+    assert_equal 2, Rinku.last_stats[:calls]
+    assert_equal 4, Rinku.stats[:calls]
+    assert_equal 3, Rinku.stats[:links][:url]
+
+    Rinku.collect_stats = :timing
+    assert_equal :timing, Rinku.collect_stats
+    Rinku.auto_link("http://a.com " * 100)
+    assert_operator Rinku.last_stats[:parse_ns][:url], :>, 0
+
+    Rinku.reset_stats
+    assert_nil Rinku.last_stats
+    assert_equal 0, Rinku.stats[:calls]
+  ensure
+    Rinku.collect_stats = false
+  end
+
+  def test_stats_per_thread
+    Rinku.collect_stats = true
+    Rinku.reset_stats
+
+    Rinku.auto_link("http://a.com")
+    other = Thread.new do
+      Rinku.auto_link_many(["www.b.com", "www.c.com", "x"])
+      Rinku.last_stats
+    end.value
+
+    assert_equal 3, other[:calls]
+    assert_equal 1, Rinku.last_stats[:calls]
+    assert_equal({ www: 0, email: 0, url: 1 }, Rinku.last_stats[:links])
+    assert_equal 4, Rinku.stats[:calls]
+
+    # the counters of threads that are gone are kept
+    4.times { Thread.new { Rinku.auto_link("www.d.com") }.join }
+    GC.start
+    assert_equal 8, Rinku.stats[:calls]
+    assert_equal 6, Rinku.stats[:links][:www]
+
+    Fiber.new { Rinku.auto_link("x") { |l| l } }.resume
+    assert_equal 1, Rinku.last_stats[:links][:url]
+    assert_equal 9, Rinku.stats[:calls]
+
+    Thread.new { Rinku.reset_stats }.join
+    assert_equal 0, Rinku.stats[:calls]
+    Rinku.auto_link("http://a.com")
+    assert_equal 1, Rinku.stats[:calls]
+  ensure
+    Rinku.collect_stats = false
+  end
+
+  def test_budgets
+    text = "http://a.com http://b.com http://c.com"
+    a = '<a href="http://a.com">http://a.com</a>'
+    b = '<a href="http://b.com">http://b.com</a>'
+
+    assert_equal "#{a} #{b} http://c.com", Rinku.auto_link(text, max_links: 2)
+    assert Rinku.truncated?
+    assert_equal "#{a} http://b.com http://c.com", Rinku.auto_link(text, max_bytes: 13)
+    assert Rinku.truncated?
+
+    # finding exactly as many links as allowed, or scanning the whole
+    # text, is not cutting it short
+    assert_equal Rinku.auto_link(text), Rinku.auto_link(text, max_links: 3, max_bytes: text.bytesize)
+    refute Rinku.truncated?
+
+    # a link found within the budget is linked whole
+    assert_equal "#{a} http://b.com http://c.com", Rinku.auto_link(text, max_bytes: 5)
+
+    long = "http://a.com " * 200_000
+    out = Rinku.auto_link(long, timeout: 1e-6)
+    assert Rinku.truncated?
+    assert out.end_with?(" http://a.com ")
+    assert_operator out.bytesize, :<, Rinku.auto_link(long).bytesize
+
+    many = Rinku.auto_link_many([text, "www.x.com"], max_links: 1)
+    assert_equal ["#{a} http://b.com http://c.com", '<a href="http://www.x.com">www.x.com</a>'], many
+    assert Rinku.truncated?
+
+    linker = Rinku::Linker.new(max_links: 1)
+    assert_equal "#{a} http://b.com http://c.com", linker.auto_link(text)
+    assert Rinku.truncated?
+
+    assert_raises(ArgumentError) { Rinku.auto_link(text, max_links: 0) }
+    assert_raises(ArgumentError) { Rinku.auto_link(text, timeout: -1) }
+    assert_raises(ArgumentError) { Rinku.auto_link(text, max_lines: 1) }
+  end
+
+  def test_truncated_per_thread_and_fiber
+    text = "http://a.com http://b.com"
+
+    Rinku.auto_link(text, max_links: 1)
+    refute Thread.new { Rinku.auto_link(text); Rinku.truncated? }.value
+    assert Rinku.truncated?
+
+    Fiber.new { Rinku.auto_link(text) { |l| l } }.resume
+    assert Rinku.truncated?
+    refute Fiber.new { Rinku.truncated? }.resume
+
+    fiber = Fiber.new { Rinku.auto_link(text, max_links: 1); Fiber.yield; Rinku.truncated? }
+    fiber.resume
+    Rinku.auto_link(text)
+    refute Rinku.truncated?
+    assert fiber.resume
+  end
 end
@@ -0,0 +1,159 @@
+require 'bundler/setup'
+$LOAD_PATH.unshift File.expand_path('../../lib', __FILE__)
+
+require 'minitest/autorun'
+require 'cgi'
+require 'rinku'
+
+# The few pieces of Rails that the helper touches, unless the real ones
+# are around
+begin
+  require 'rails'
+  require 'action_view'
+rescue LoadError
+  module Rails
+    def self.version
+      "7.1.0"
+    end
+  end
+
+  module ActionView
+    module Helpers
+      module TextHelper
+      end
+    end
+  end
+
+  class SafeString < String
+    def html_safe?
+      true
+    end
+
+    def to_s
+      self
+    end
+  end
+
+  class Object
+    def blank?
+      respond_to?(:empty?) ? !!empty? : !self
+    end
+
+    def html_safe?
+      false
+    end
+  end
+
+  class String
+    def html_safe
+      SafeString.new(self)
+    end
+  end
+end
+
+require 'rails_rinku'
+
+class RailsRinkuTest < Minitest::Test
+  class View
+    include ActionView::Helpers::TextHelper
+
+    def tag_builder
+      self
+    end
+
+    def tag_options(options)
+      return if options.empty?
+      options.map { |key, value| %( #{key}="#{CGI.escapeHTML(value.to_s)}") }.join
+    end
+  end
+
+  def setup
+    @view = View.new
+    linkers.clear
+  end
+
+  def linkers
+    RailsRinku.instance_variable_get(:@linkers)
+  end
+
+  def test_escapes_unsafe_text
+    text = %(<b>"www.rinku.com"</b> & me@rinku.com)
+    expected = Rinku.auto_link(CGI.escapeHTML(text))
+
+    assert_equal expected, @view.auto_link(text)
+    assert @view.auto_link(text).html_safe?
+    assert_equal Rinku.auto_link(text), @view.auto_link(text.html_safe)
+    assert_equal '', @view.auto_link('')
+  end
+
+  def test_coerces_text
+    text = Object.new
+    def text.to_s
+      "<www.rinku.com>"
+    end
+
+    assert_equal Rinku.auto_link("&lt;www.rinku.com&gt;"), @view.auto_link(text)
+    assert_equal "42", @view.auto_link(42)
+  end
+
+  def test_options_forms
+    text = "www.rinku.com me@rinku.com"
+    urls = Rinku.auto_link(text, :urls, ' class="x"')
+
+    assert_equal Rinku.auto_link(text), @view.auto_link(text)
+    assert_equal urls, @view.auto_link(text, :urls, class: "x")
+    assert_equal urls, @view.auto_link(text, :urls, { class: "x" })
+    assert_equal urls, @view.auto_link(text, link: :urls, html: { class: "x" })
+    assert_equal urls, @view.auto_link(text, :urls, { class: "x" }, nil, { link: :all })
+    assert_equal Rinku.auto_link(text, :email_addresses), @view.auto_link(text, :email_addresses)
+
+    html = "<b>www.rinku.com</b>".html_safe
+    assert_equal html, @view.auto_link(html, :all, nil, ["b"])
+    assert_equal html, @view.auto_link(html, skip: ["b"])
+  end
+
+  def test_does_not_change_the_options
+    options = { link: :urls, html: { class: "x" } }
+    @view.auto_link("www.rinku.com", options)
+    assert_equal({ link: :urls, html: { class: "x" } }, options)
+
+    options = {}
+    @view.auto_link("www.rinku.com", options)
+    assert_empty options
+  end
+
+  def test_caches_linkers
+    text = "www.rinku.com"
+    html = { class: "x", data: { id: String.new("1") } }
+
+    first = @view.auto_link(text, html: html)
+    assert_equal 1, linkers.size
+    assert_equal first, @view.auto_link(text, html: { class: "x", data: { id: "1" } })
+    assert_equal 1, linkers.size
+
+    # the cached key doesn't follow the caller's Hash
+    html[:data][:id] << "2"
+    key = linkers.keys.first
+    assert key.frozen?
+    assert key[1][:data][:id].frozen?
+    assert_equal "1", key[1][:data][:id]
+
+    refute_equal first, @view.auto_link(text, html: html)
+    assert_equal 2, linkers.size
+
+    # unsafe and safe text are linked with different flags
+    @view.auto_link(text.html_safe, html: html)
+    assert_equal 3, linkers.size
+  end
+
+  def test_cache_starts_over_when_full
+    RailsRinku::LINKER_CACHE_SIZE.times do |i|
+      @view.auto_link("www.rinku.com", html: { id: i })
+    end
+    assert_equal RailsRinku::LINKER_CACHE_SIZE, linkers.size
+
+    out = @view.auto_link("www.rinku.com", html: { id: "last" })
+    assert_equal Rinku.auto_link("www.rinku.com", :all, ' id="last"'), out
+    assert_equal 1, linkers.size
+  end
+end